@@ -24,14 +24,128 @@
 
 #include "./include/client_vec.h"
 
+/**
+ * @brief Finds the bucket of a client ID or the empty bucket
+ * where the ID should be inserted.
+ *
+ * @param clients clients vector structure.
+ * @param client_id id of the client.
+ * @param hash hash of the client id.
+ * @return size_t bucket index.
+ */
+static size_t clients_vec_probe_id(client_vec_t *clients, const char *client_id, uint64_t hash) {
+    size_t mask = clients->id_buckets_len - 1;
+    size_t bucket = (size_t)hash & mask;
+
+    /* Linear probing, the table is never full */
+    while (clients->id_buckets[bucket] != 0) {
+        client_type_t *client = clients->entities[clients->id_buckets[bucket] - 1];
+
+        if ((client->id_hash == hash) && (strcmp(client->id, client_id) == 0)) {
+            break;
+        }
+
+        bucket = (bucket + 1) & mask;
+    }
+
+    return bucket;
+}
+
+/**
+ * @brief Doubles the number of ID buckets and reinserts the clients.
+ *
+ * @param clients clients vector structure.
+ * @return err_t OK if the buckets were resized or error otherwise.
+ */
+static err_t clients_vec_grow_ids(client_vec_t *clients) {
+    size_t buckets_len = clients->id_buckets_len * REALLOC_FACTOR;
+
+    size_t *buckets = calloc(buckets_len, sizeof *buckets);
+    if (buckets == NULL) {
+        return CLIENTS_VEC_FAILED_REALLOC;
+    }
+
+    free(clients->id_buckets);
+    clients->id_buckets = buckets;
+    clients->id_buckets_len = buckets_len;
+
+    for (size_t iter = 0; iter < clients->len; ++iter) {
+        size_t bucket = clients_vec_probe_id(
+            clients,
+            clients->entities[iter]->id,
+            clients->entities[iter]->id_hash
+        );
+
+        clients->id_buckets[bucket] = iter + 1;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Sets the client of a socket file descriptor,
+ * the fd table grows to fit the file descriptor.
+ *
+ * @param clients clients vector structure.
+ * @param client_fd valid socket file descriptor.
+ * @param slot client index + 1 or 0 to clear the fd.
+ * @return err_t OK if the fd was set or error otherwise.
+ */
+static err_t clients_vec_set_fd(client_vec_t *clients, int client_fd, size_t slot) {
+    if ((size_t)client_fd >= clients->fd_table_len) {
+        size_t fd_table_len = clients->fd_table_len;
+
+        while ((size_t)client_fd >= fd_table_len) {
+            fd_table_len *= REALLOC_FACTOR;
+        }
+
+        size_t *fd_table_real = realloc(clients->fd_table, sizeof *fd_table_real * fd_table_len);
+        if (fd_table_real == NULL) {
+            return CLIENTS_VEC_FAILED_REALLOC;
+        }
+
+        memset(
+            fd_table_real + clients->fd_table_len,
+            0,
+            sizeof *fd_table_real * (fd_table_len - clients->fd_table_len)
+        );
+
+        clients->fd_table = fd_table_real;
+        clients->fd_table_len = fd_table_len;
+    }
+
+    clients->fd_table[client_fd] = slot;
+
+    return OK;
+}
+
+/**
+ * @brief Finds the client of a socket file descriptor.
+ *
+ * @param clients clients vector structure.
+ * @param client_fd valid socket file descriptor.
+ * @param client_idx pointer to variable to set the index of the client.
+ * @return err_t OK if the client was found or CLIENTS_VEC_CLIENT_NOT_FOUND otherwise.
+ */
+static err_t clients_vec_find_fd(client_vec_t *clients, int client_fd, size_t *client_idx) {
+    if (((size_t)client_fd >= clients->fd_table_len) || (clients->fd_table[client_fd] == 0)) {
+        return CLIENTS_VEC_CLIENT_NOT_FOUND;
+    }
+
+    *client_idx = clients->fd_table[client_fd] - 1;
+
+    return OK;
+}
+
 /**
  * @brief Creates a clients vec object for clients data and metadata.
  *
  * @param clients pointer to vector structure to allocate must be NULL.
  * @param init_clients initial vector length to allocate.
+ * @param queue_limit max number of outbound bytes queued for a client.
  * @return err_t OK if vector could be allocated, error otherwise.
  */
-err_t create_clients_vec(client_vec_t **clients, size_t init_clients) {
+err_t create_clients_vec(client_vec_t **clients, size_t init_clients, size_t queue_limit) {
     if ((clients == NULL) || (*clients != NULL)) {
         return CLIENTS_VEC_INPUT_IS_NOT_NULL;
     }
@@ -44,12 +158,36 @@ err_t create_clients_vec(client_vec_t **clients, size_t init_clients) {
 
     (*clients)->len = 0;
     (*clients)->capacity = init_clients;
+    (*clients)->queue_limit = queue_limit;
     (*clients)->entities = malloc(sizeof *(*clients)->entities * (*clients)->capacity);
 
     if ((*clients)->entities == NULL) {
         return CLIENTS_VEC_FAILED_ALLOCATION;
     }
 
+    /* Smallest power of two with enough free buckets */
+    (*clients)->id_buckets_len = 1;
+    while ((*clients)->id_buckets_len < init_clients * CLIENTS_VEC_MAX_LOAD) {
+        (*clients)->id_buckets_len <<= 1;
+    }
+
+    (*clients)->id_buckets = calloc((*clients)->id_buckets_len, sizeof *(*clients)->id_buckets);
+
+    (*clients)->fd_table_len = INIT_FD_TABLE_LEN;
+    (*clients)->fd_table = calloc((*clients)->fd_table_len, sizeof *(*clients)->fd_table);
+
+    (*clients)->topic_table = NULL;
+    if (((*clients)->id_buckets == NULL) || ((*clients)->fd_table == NULL) ||
+        (create_topic_table(&(*clients)->topic_table, INIT_TOPIC_TABLE_LEN) != OK)) {
+        free((*clients)->id_buckets);
+        free((*clients)->fd_table);
+        free((*clients)->entities);
+        free(*clients);
+        *clients = NULL;
+
+        return CLIENTS_VEC_FAILED_ALLOCATION;
+    }
+
     return OK;
 }
 
@@ -66,20 +204,34 @@ err_t free_clients_vec(client_vec_t **clients) {
     }
 
     for (size_t iter = 0; iter < (*clients)->len; ++iter) {
-        for (size_t iter_j = 0; iter_j < (*clients)->entities[iter].topics_len; ++iter_j) {
-            free((*clients)->entities[iter].topics[iter_j]);
+        for (size_t iter_j = 0; iter_j < (*clients)->entities[iter]->topics_len; ++iter_j) {
+            free((*clients)->entities[iter]->topics[iter_j]);
+        }
+
+        free((*clients)->entities[iter]->topics);
+        free((*clients)->entities[iter]->id);
+        free((*clients)->entities[iter]->options);
+        for (size_t iter_j = 0; iter_j < (*clients)->entities[iter]->ready_msgs_len; ++iter_j) {
+            tcp_frame_release(&(*clients)->entities[iter]->ready_msgs[iter_j]);
         }
 
-        free((*clients)->entities[iter].topics);
-        free((*clients)->entities[iter].id);
-        free((*clients)->entities[iter].options);
-        free((*clients)->entities[iter].ready_msgs);
+        free((*clients)->entities[iter]->ready_msgs);
+        free_tcp_reader(&(*clients)->entities[iter]->reader);
+        free_tcp_writer(&(*clients)->entities[iter]->writer);
+        free((*clients)->entities[iter]);
     }
 
     if ((*clients)->entities != NULL) {
         free((*clients)->entities);
     }
 
+    free((*clients)->id_buckets);
+    free((*clients)->fd_table);
+
+    if ((*clients)->topic_table != NULL) {
+        free_topic_table(&(*clients)->topic_table);
+    }
+
     free(*clients);
     *clients = NULL;
 
@@ -87,40 +239,27 @@ err_t free_clients_vec(client_vec_t **clients) {
 }
 
 /**
- * @brief Connect a client to the server, if the new client's
- * ID is found if another client with the same id is active,
- * the function will return with an error, else if the client
- * is dead the function returns with OK and a new socket file
- * descripot is assigned again for the client in the structure,
- * else a new client is generated and unction returns with OK.
+ * @brief Allocates a DEAD client record without any connection buffers
+ * and appends it to the vector, the client is indexed by its ID.
  *
  * @param clients clients vector structure.
- * @param client_id id of the client to register.
- * @param client_fd valid socket file descripor assigned for the client.
- * @return err_t OK if client was registered successfully or error otherwise.
+ * @param client_id id of the client.
+ * @param id_hash hash of the client id.
+ * @param client_idx pointer to variable to set the index of the new client.
+ * @return err_t OK if the client was appended or error otherwise.
  */
-err_t register_new_client(client_vec_t *clients, char *client_id, int client_fd) {
-    if (clients == NULL) {
-        return CLIENTS_VEC_INPUT_IS_NULL;
-    }
-
-    /* Checks if client was ever registered */
-    for (size_t iter = 0; iter < clients->len; ++iter) {
-        if (strcmp(clients->entities[iter].id, client_id) == 0) {
-            if (clients->entities[iter].status == ACTIVE) {
-                return CLIENT_VEC_CLIENT_ALREADY_CONNECTED;
-            }
-
-            clients->entities[iter].fd = client_fd;
-            clients->entities[iter].status = ACTIVE;
-
-            return OK;
+static err_t clients_vec_append(client_vec_t *clients, const char *client_id,
+    uint64_t id_hash, size_t *client_idx) {
+    /* Keeps enough free buckets for the new client */
+    if ((clients->len + 1) * CLIENTS_VEC_MAX_LOAD > clients->id_buckets_len) {
+        if (clients_vec_grow_ids(clients) != OK) {
+            return CLIENTS_VEC_FAILED_REALLOC;
         }
     }
 
     /* Adds memory for new clients */
     if (clients->len == clients->capacity) {
-        client_type_t *entities_real = realloc(
+        client_type_t **entities_real = realloc(
             clients->entities,
             sizeof *clients->entities * clients->capacity * REALLOC_FACTOR
         );
@@ -133,54 +272,220 @@ err_t register_new_client(client_vec_t *clients, char *client_id, int client_fd)
         clients->capacity *= REALLOC_FACTOR;
     }
 
-    clients->entities[clients->len].id = malloc(MAX_ID_CLIENT_LEN);
-    if (clients->entities[clients->len].id == NULL) {
+    /*
+     * Every client record is allocated on its own so
+     * pointers to it stay valid when the vector grows,
+     * the connection buffers start cleared
+     */
+    client_type_t *client = calloc(1, sizeof *client);
+    if (client == NULL) {
+        return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
+    }
+
+    client->id = malloc(MAX_ID_CLIENT_LEN);
+    if (client->id == NULL) {
+        free(client);
+
         return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
     }
 
-    clients->entities[clients->len].topics_len = 0;
-    clients->entities[clients->len].topic_capacity = INIT_TOPICS_CAPACITY;
+    client->topics_len = 0;
+    client->topic_capacity = INIT_TOPICS_CAPACITY;
 
-    clients->entities[clients->len].topics =
-        malloc(sizeof *clients->entities[clients->len].topics * INIT_TOPICS_CAPACITY);
-    if (clients->entities[clients->len].topics == NULL) {
-        free(clients->entities[clients->len].id);
+    client->topics = malloc(sizeof *client->topics * INIT_TOPICS_CAPACITY);
+    if (client->topics == NULL) {
+        free(client->id);
+        free(client);
 
         return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
     }
 
-    clients->entities[clients->len].options =
-        malloc(sizeof *clients->entities[clients->len].options * INIT_TOPICS_CAPACITY);
-    if (clients->entities[clients->len].options == NULL) {
-        free(clients->entities[clients->len].id);
-        free(clients->entities[clients->len].topics);
+    client->options = malloc(sizeof *client->options * INIT_TOPICS_CAPACITY);
+    if (client->options == NULL) {
+        free(client->id);
+        free(client->topics);
+        free(client);
 
         return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
     }
 
-    clients->entities[clients->len].ready_msgs_len = 0;
-    clients->entities[clients->len].ready_msgs_capacity = INIT_TOPICS_CAPACITY;
+    client->ready_msgs_len = 0;
+    client->ready_msgs_capacity = INIT_TOPICS_CAPACITY;
 
-    clients->entities[clients->len].ready_msgs =
-        malloc(sizeof *clients->entities[clients->len].ready_msgs * INIT_TOPICS_CAPACITY);
-    if (clients->entities[clients->len].ready_msgs == NULL) {
-        free(clients->entities[clients->len].id);
-        free(clients->entities[clients->len].topics);
-        free(clients->entities[clients->len].options);
+    client->ready_msgs = malloc(sizeof *client->ready_msgs * INIT_TOPICS_CAPACITY);
+    if (client->ready_msgs == NULL) {
+        free(client->id);
+        free(client->topics);
+        free(client->options);
+        free(client);
 
         return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
     }
 
-    strcpy(clients->entities[clients->len].id, client_id);
+    strcpy(client->id, client_id);
 
-    clients->entities[clients->len].fd = client_fd;
-    clients->entities[clients->len].status = ACTIVE;
+    client->id_hash = id_hash;
+    client->idx = clients->len;
+    client->fd = -1;
+    client->status = DEAD;
+
+    clients->entities[clients->len] = client;
+    clients->id_buckets[clients_vec_probe_id(clients, client_id, id_hash)] = clients->len + 1;
+    *client_idx = clients->len;
 
     (clients->len)++;
 
     return OK;
 }
 
+/**
+ * @brief Allocates the connection buffers of a DEAD client and
+ * links the client with its socket file descriptor.
+ *
+ * @param clients clients vector structure.
+ * @param client_idx valid index of a DEAD client.
+ * @param client_fd valid socket file descriptor assigned for the client.
+ * @param client_proto wire format spoken by the client.
+ * @return err_t OK if the client is ACTIVE or error otherwise.
+ */
+static err_t clients_vec_connect(client_vec_t *clients, size_t client_idx,
+    int client_fd, tcp_proto_t client_proto) {
+    client_type_t *client = clients->entities[client_idx];
+
+    if (init_tcp_reader(&client->reader, client_proto) != OK) {
+        return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
+    }
+
+    if (init_tcp_writer(&client->writer, client_proto, clients->queue_limit) != OK) {
+        free_tcp_reader(&client->reader);
+
+        return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
+    }
+
+    if (clients_vec_set_fd(clients, client_fd, client_idx + 1) != OK) {
+        free_tcp_reader(&client->reader);
+        free_tcp_writer(&client->writer);
+
+        return CLIENTS_VEC_FAILED_REGISTER_ALLOCATION;
+    }
+
+    client->fd = client_fd;
+    client->proto = client_proto;
+    client->status = ACTIVE;
+
+    return OK;
+}
+
+/**
+ * @brief Removes the last appended client, used when a new
+ * client could not be connected. The client was the last one
+ * inserted in the ID table so clearing its bucket does not
+ * break the probing of the other clients.
+ *
+ * @param clients clients vector structure.
+ */
+static void clients_vec_pop(client_vec_t *clients) {
+    client_type_t *client = clients->entities[clients->len - 1];
+
+    clients->id_buckets[clients_vec_probe_id(clients, client->id, client->id_hash)] = 0;
+    (clients->len)--;
+
+    free(client->id);
+    free(client->topics);
+    free(client->options);
+    free(client->ready_msgs);
+    free(client);
+}
+
+/**
+ * @brief Connect a client to the server, if the new client's
+ * ID is found if another client with the same id is active,
+ * the function will return with an error, else if the client
+ * is dead the function returns with OK and a new socket file
+ * descripot is assigned again for the client in the structure,
+ * else a new client is generated and unction returns with OK.
+ *
+ * @param clients clients vector structure.
+ * @param client_id id of the client to register.
+ * @param client_fd valid socket file descripor assigned for the client.
+ * @param client_proto wire format spoken by the client.
+ * @param client_idx pointer to variable to set the index of the registered client.
+ * @return err_t OK if client was registered successfully or error otherwise.
+ */
+err_t register_new_client(client_vec_t *clients, char *client_id, int client_fd,
+    tcp_proto_t client_proto, size_t *client_idx) {
+    if (clients == NULL) {
+        return CLIENTS_VEC_INPUT_IS_NULL;
+    }
+
+    if (client_fd < 0) {
+        return CLIENTS_VEC_INPUT_FD_IDX_INVALID;
+    }
+
+    err_t err = OK;
+
+    /* Checks if client was ever registered */
+    uint64_t id_hash = hash_str(client_id);
+    size_t bucket = clients_vec_probe_id(clients, client_id, id_hash);
+
+    if (clients->id_buckets[bucket] != 0) {
+        size_t idx = clients->id_buckets[bucket] - 1;
+
+        if (clients->entities[idx]->status == ACTIVE) {
+            return CLIENT_VEC_CLIENT_ALREADY_CONNECTED;
+        }
+
+        if ((err = clients_vec_connect(clients, idx, client_fd, client_proto)) != OK) {
+            return err;
+        }
+
+        *client_idx = idx;
+
+        return OK;
+    }
+
+    size_t idx = 0;
+    if ((err = clients_vec_append(clients, client_id, id_hash, &idx)) != OK) {
+        return err;
+    }
+
+    if ((err = clients_vec_connect(clients, idx, client_fd, client_proto)) != OK) {
+        clients_vec_pop(clients);
+
+        return err;
+    }
+
+    *client_idx = idx;
+
+    return OK;
+}
+
+/**
+ * @brief Restores a DEAD client without any connection, if the
+ * client is already registered just its index is returned.
+ *
+ * @param clients clients vector structure.
+ * @param client_id id of the client to restore.
+ * @param client_idx pointer to variable to set the index of the client.
+ * @return err_t OK if the client was restored or error otherwise.
+ */
+err_t restore_client(client_vec_t *clients, const char *client_id, size_t *client_idx) {
+    if ((clients == NULL) || (client_id == NULL) || (client_idx == NULL)) {
+        return CLIENTS_VEC_INPUT_IS_NULL;
+    }
+
+    uint64_t id_hash = hash_str(client_id);
+    size_t bucket = clients_vec_probe_id(clients, client_id, id_hash);
+
+    if (clients->id_buckets[bucket] != 0) {
+        *client_idx = clients->id_buckets[bucket] - 1;
+
+        return OK;
+    }
+
+    return clients_vec_append(clients, client_id, id_hash, client_idx);
+}
+
 /**
  * @brief Assigns to a client a DEAD status and sets the socket file
  * descriptor to -1. Does NOT free the memory assigned for a client, because
@@ -200,21 +505,27 @@ err_t close_active_client(client_vec_t *clients, int client_fd, size_t *client_i
         return CLIENTS_VEC_INPUT_FD_IDX_INVALID;
     }
 
-    for (size_t iter = 0; iter < clients->len; ++iter) {
-        if (clients->entities[iter].fd == client_fd) {
-            if (clients->entities[iter].status == DEAD) {
-                return CLIENTS_VEC_CLIENT_ALREADY_DEAD;
-            }
+    size_t idx = 0;
+    if (clients_vec_find_fd(clients, client_fd, &idx) != OK) {
+        return CLIENTS_VEC_CLOSE_CLIENT_NOT_FOUND;
+    }
 
-            clients->entities[iter].status = DEAD;
-            clients->entities[iter].fd = -1;
-            *client_idx = iter;
+    client_type_t *client = clients->entities[idx];
 
-            return OK;
-        }
+    if (client->status == DEAD) {
+        return CLIENTS_VEC_CLIENT_ALREADY_DEAD;
     }
 
-    return CLIENTS_VEC_CLOSE_CLIENT_NOT_FOUND;
+    client->status = DEAD;
+    client->fd = -1;
+    clients->fd_table[client_fd] = 0;
+
+    /* Dead clients do not keep any connection buffers */
+    free_tcp_reader(&client->reader);
+    free_tcp_writer(&client->writer);
+    *client_idx = idx;
+
+    return OK;
 }
 
 /**
@@ -231,13 +542,14 @@ const char* get_client_id(client_vec_t *clients, size_t client_idx) {
         return "";
     }
 
-    return clients->entities[client_idx].id;
+    return clients->entities[client_idx]->id;
 }
 
 /**
  * @brief Adds a new topic and a new option for the selected topic
  * for the specified client, the client is found over its valid socket
- * file descriptor. If the topic already exists the option will be updated
+ * file descriptor. If the topic already exists the option will be updated.
+ * The topic index is updated with the new subscriber.
  *
  * @param clients clients vector structure.
  * @param client_fd valid socket file descriptor assigned for the client.
@@ -255,67 +567,99 @@ err_t subscribe_client_to_topic(client_vec_t *clients, int client_fd,
         return CLIENTS_VEC_INPUT_FD_IDX_INVALID;
     }
 
-    for (size_t iter = 0; iter < clients->len; ++iter) {
-        if (clients->entities[iter].fd == client_fd) {
-
-            /* Check if the topic already exists, if yes update the options */
-            for (size_t iter_j = 0; iter_j < clients->entities[iter].topics_len; ++iter_j) {
-                if (strcmp(clients->entities[iter].topics[iter_j], client_topic) == 0) {
-                    clients->entities[iter].options[iter_j] = client_sf;
+    size_t idx = 0;
+    if (clients_vec_find_fd(clients, client_fd, &idx) != OK) {
+        return CLIENTS_VEC_CLIENT_NOT_FOUND;
+    }
 
-                    return OK;
-                }
-            }
+    return subscribe_client_idx_to_topic(clients, idx, client_topic, client_sf);
+}
 
-            /* Adds more memory for new topics */
-            if (clients->entities[iter].topics_len == clients->entities[iter].topic_capacity) {
-                char **topics_real = realloc(
-                    clients->entities[iter].topics,
-                    sizeof * clients->entities[iter].topics *
-                    clients->entities[iter].topic_capacity * REALLOC_FACTOR
-                );
+/**
+ * @brief Adds a new topic and a new option for the selected topic
+ * for the client found over its index, the client can be DEAD.
+ * If the topic already exists the option will be updated.
+ * The topic index is updated with the new subscriber.
+ *
+ * @param clients clients vector structure.
+ * @param client_idx valid client index.
+ * @param client_topic string topic name to add.
+ * @param client_sf enum option class for the specified topic name.
+ * @return err_t OK if the topic was addded successfully or error otherwise.
+ */
+err_t subscribe_client_idx_to_topic(client_vec_t *clients, size_t client_idx,
+    const char *client_topic, client_options_t client_sf) {
+    if (clients == NULL) {
+        return CLIENTS_VEC_INPUT_IS_NULL;
+    }
 
-                if (topics_real == NULL) {
-                    return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
-                }
+    if (client_idx >= clients->len) {
+        return CLIENTS_VEC_INDEX_OUT_OF_BOUND;
+    }
 
-                clients->entities[iter].topics = topics_real;
+    client_type_t *client = clients->entities[client_idx];
 
-                client_options_t *options_real = realloc(
-                    clients->entities[iter].options,
-                    sizeof * clients->entities[iter].options *
-                    clients->entities[iter].topic_capacity * REALLOC_FACTOR
-                );
+    uint32_t topic_id = 0;
 
-                if (options_real == NULL) {
-                    return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
-                }
+    /* Intern the topic in order to index the client as a subscriber */
+    if (topic_table_intern(clients->topic_table, client_topic, &topic_id) != OK) {
+        return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
+    }
 
-                clients->entities[iter].options = options_real;
-                clients->entities[iter].topic_capacity *= REALLOC_FACTOR;
-            }
+    /* Check if the topic already exists, if yes update the options */
+    for (size_t iter_j = 0; iter_j < client->topics_len; ++iter_j) {
+        if (strcmp(client->topics[iter_j], client_topic) == 0) {
+            client->options[iter_j] = client_sf;
 
-            clients->entities[iter].topics[clients->entities[iter].topics_len] =
-                malloc(strlen(client_topic) + 1);
+            return topic_table_add_sub(clients->topic_table, topic_id, client_idx, client_sf);
+        }
+    }
 
-            if (clients->entities[iter].topics[clients->entities[iter].topics_len] == NULL) {
-                return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
-            }
+    /* Adds more memory for new topics */
+    if (client->topics_len == client->topic_capacity) {
+        char **topics_real = realloc(
+            client->topics,
+            sizeof *client->topics * client->topic_capacity * REALLOC_FACTOR
+        );
 
-            strcpy(
-                clients->entities[iter].topics[clients->entities[iter].topics_len],
-                client_topic
-            );
+        if (topics_real == NULL) {
+            return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
+        }
 
-            clients->entities[iter].options[clients->entities[iter].topics_len] = client_sf;
+        client->topics = topics_real;
 
-            (clients->entities[iter].topics_len)++;
+        client_options_t *options_real = realloc(
+            client->options,
+            sizeof *client->options * client->topic_capacity * REALLOC_FACTOR
+        );
 
-            return OK;
+        if (options_real == NULL) {
+            return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
         }
+
+        client->options = options_real;
+        client->topic_capacity *= REALLOC_FACTOR;
+    }
+
+    client->topics[client->topics_len] = malloc(strlen(client_topic) + 1);
+
+    if (client->topics[client->topics_len] == NULL) {
+        return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
+    }
+
+    strcpy(client->topics[client->topics_len], client_topic);
+
+    if (topic_table_add_sub(clients->topic_table, topic_id, client_idx, client_sf) != OK) {
+        free(client->topics[client->topics_len]);
+
+        return CLIENTS_VEC_COUND_NOT_ADD_A_TOPIC;
     }
 
-    return CLIENTS_VEC_CLIENT_NOT_FOUND;
+    client->options[client->topics_len] = client_sf;
+
+    (client->topics_len)++;
+
+    return OK;
 }
 
 /**
@@ -336,47 +680,73 @@ err_t unsubscribe_client_from_topic(client_vec_t *clients, int client_fd, char *
         return CLIENTS_VEC_INPUT_FD_IDX_INVALID;
     }
 
-    for (size_t iter = 0; iter < clients->len; ++iter) {
-        if (clients->entities[iter].fd == client_fd) {
-            for (size_t iter_j = 0; iter_j < clients->entities[iter].topics_len; ++iter_j) {
-                if (strcmp(clients->entities[iter].topics[iter_j], client_topic) == 0) {
-                    /* Remove topic from client metadata */
+    size_t idx = 0;
+    if (clients_vec_find_fd(clients, client_fd, &idx) != OK) {
+        return CLIENTS_VEC_CLIENT_NOT_FOUND;
+    }
+
+    return unsubscribe_client_idx_from_topic(clients, idx, client_topic);
+}
+
+/**
+ * @brief Removes a topic and it's option for the client found
+ * over its index, the client can be DEAD.
+ *
+ * @param clients clients vector structure.
+ * @param client_idx valid client index.
+ * @param client_topic string topic name to remove
+ * @return err_t OK if the topic was removed successfully or error otherwise.
+ */
+err_t unsubscribe_client_idx_from_topic(client_vec_t *clients, size_t client_idx, const char *client_topic) {
+    if (clients == NULL) {
+        return CLIENTS_VEC_INPUT_IS_NULL;
+    }
 
-                    free(clients->entities[iter].topics[iter_j]);
+    if (client_idx >= clients->len) {
+        return CLIENTS_VEC_INDEX_OUT_OF_BOUND;
+    }
+
+    client_type_t *client = clients->entities[client_idx];
 
-                    for (; iter_j < clients->entities[iter].topics_len - 1; ++iter_j) {
-                        clients->entities[iter].topics[iter_j] =
-                            clients->entities[iter].topics[iter_j + 1];
-                        clients->entities[iter].options[iter_j] =
-                            clients->entities[iter].options[iter_j + 1];
-                    }
+    for (size_t iter_j = 0; iter_j < client->topics_len; ++iter_j) {
+        if (strcmp(client->topics[iter_j], client_topic) == 0) {
+            /* Remove client from the topic index and from the client metadata */
+
+            uint32_t topic_id = 0;
+            if (topic_table_find(clients->topic_table, client_topic, &topic_id) == OK) {
+                topic_table_remove_sub(clients->topic_table, topic_id, client_idx);
+            }
 
-                    (clients->entities[iter].topics_len)--;
+            free(client->topics[iter_j]);
 
-                    return OK;
-                }
+            for (; iter_j < client->topics_len - 1; ++iter_j) {
+                client->topics[iter_j] = client->topics[iter_j + 1];
+                client->options[iter_j] = client->options[iter_j + 1];
             }
 
-            return CLIENTS_VEC_COUND_NOT_FIND_TOPIC;
+            (client->topics_len)--;
+
+            return OK;
         }
     }
 
-    return CLIENTS_VEC_CLIENT_NOT_FOUND;
+    return CLIENTS_VEC_COUND_NOT_FIND_TOPIC;
 }
 
 /**
  * @brief Stackes a UDP message for a client. The client
  * stores unsent messages opon Store and Forward functionality.
+ * The client holds a reference of the shared frame.
  *
  * The client is found over his index to generate a O(1) search
  * for fast time response.
  *
  * @param clients clients vector structure.
- * @param udp_msg UDP message to store in the queue.
+ * @param frame shared frame of the UDP message to store in the queue.
  * @param client_idx valid client index in order to find the client.
  * @return err_t OK if the message wasa stacked successfully or error otherwsie
  */
-err_t add_topic_msg_for_client(client_vec_t *clients, udp_type_t *udp_msg, size_t client_idx) {
+err_t add_topic_msg_for_client(client_vec_t *clients, tcp_frame_t *frame, size_t client_idx) {
     if (clients == NULL) {
         return CLIENTS_VEC_INPUT_IS_NULL;
     }
@@ -386,26 +756,65 @@ err_t add_topic_msg_for_client(client_vec_t *clients, udp_type_t *udp_msg, size_
     }
 
     /* Adds more memory for the stacked udp messages */
-    if (clients->entities[client_idx].ready_msgs_len ==
-        clients->entities[client_idx].ready_msgs_capacity) {
+    if (clients->entities[client_idx]->ready_msgs_len ==
+        clients->entities[client_idx]->ready_msgs_capacity) {
 
-        udp_type_t **ready_msgs_real = realloc(
-            clients->entities[client_idx].ready_msgs,
-            sizeof *clients->entities[client_idx].ready_msgs *
-            clients->entities[client_idx].ready_msgs_capacity * REALLOC_FACTOR
+        tcp_frame_t **ready_msgs_real = realloc(
+            clients->entities[client_idx]->ready_msgs,
+            sizeof *clients->entities[client_idx]->ready_msgs *
+            clients->entities[client_idx]->ready_msgs_capacity * REALLOC_FACTOR
         );
 
         if (ready_msgs_real == NULL) {
             return CLIENTS_VEC_FAILED_REALLOC;
         }
 
-        clients->entities[client_idx].ready_msgs = ready_msgs_real;
-        clients->entities[client_idx].ready_msgs_capacity *= REALLOC_FACTOR;
+        clients->entities[client_idx]->ready_msgs = ready_msgs_real;
+        clients->entities[client_idx]->ready_msgs_capacity *= REALLOC_FACTOR;
     }
 
     clients->entities[client_idx]
-        .ready_msgs[clients->entities[client_idx].ready_msgs_len] = udp_msg;
-    (clients->entities[client_idx].ready_msgs_len)++;
+        ->ready_msgs[clients->entities[client_idx]->ready_msgs_len] = tcp_frame_acquire(frame);
+    (clients->entities[client_idx]->ready_msgs_len)++;
+
+    return OK;
+}
+
+/**
+ * @brief Drops the oldest stacked UDP messages of a client,
+ * the client releases its references of the shared frames.
+ *
+ * @param clients clients vector structure.
+ * @param msgs number of messages to drop.
+ * @param client_idx valid client index in order to find the client.
+ * @return err_t OK if the messages were dropped or error otherwise.
+ */
+err_t drop_topic_msgs_for_client(client_vec_t *clients, size_t msgs, size_t client_idx) {
+    if (clients == NULL) {
+        return CLIENTS_VEC_INPUT_IS_NULL;
+    }
+
+    if (client_idx >= clients->len) {
+        return CLIENTS_VEC_INDEX_OUT_OF_BOUND;
+    }
+
+    client_type_t *client = clients->entities[client_idx];
+
+    if (msgs > client->ready_msgs_len) {
+        msgs = client->ready_msgs_len;
+    }
+
+    for (size_t iter = 0; iter < msgs; ++iter) {
+        tcp_frame_release(&client->ready_msgs[iter]);
+    }
+
+    memmove(
+        client->ready_msgs,
+        client->ready_msgs + msgs,
+        sizeof *client->ready_msgs * (client->ready_msgs_len - msgs)
+    );
+
+    client->ready_msgs_len -= msgs;
 
     return OK;
 }
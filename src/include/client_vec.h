@@ -27,8 +27,12 @@
 
 #include "./utils.h"
 #include "./udp_type.h"
+#include "./tcp_type.h"
+#include "./topic_table.h"
 
 #define INIT_TOPICS_CAPACITY 10
+#define INIT_FD_TABLE_LEN           64
+#define CLIENTS_VEC_MAX_LOAD        2           /* Buckets per client, at least */
 
 /**
  * @brief Enum type class in order to
@@ -58,21 +62,40 @@ typedef enum client_options_s {
  */
 typedef struct client_type_s {
     char                *id;                    /* Unique client ID */
+    uint64_t            id_hash;
+    size_t              idx;                    /* Index in the clients vector */
     client_status_t     status;
     client_options_t    *options;               /* Store and forward options */
     int                 fd;                     /* Open socket file descriptor */
+    tcp_proto_t         proto;                  /* Wire format of the connection */
+    tcp_reader_t        reader;                 /* Partial frames of the connection */
+    tcp_writer_t        writer;                 /* Frames the socket could not take yet */
+    uint8_t             send_listed;            /* Waits for a send of the io_uring backend */
     char                **topics;               /* Subscribed topic names */
     size_t              topics_len;
     size_t              topic_capacity;
-    udp_type_t          **ready_msgs;           /* Unsent UDP messages ready to be sent */
+    tcp_frame_t         **ready_msgs;           /* Shared frames of the unsent UDP messages */
     size_t              ready_msgs_len;
     size_t              ready_msgs_capacity;
 } client_type_t;
 
+/**
+ * @brief Struct class type of the registered clients. The
+ * clients are found by ID with an open addressing hash table
+ * and by socket file descriptor with a table indexed by fd,
+ * both tables keep indexes of the stable client records.
+ *
+ */
 typedef struct client_vec_s {
     size_t          len;
     size_t          capacity;
-    client_type_t   *entities;
+    client_type_t   **entities;             /* Stable client records */
+    size_t          *id_buckets;            /* Client index + 1 or 0 for an empty bucket */
+    size_t          id_buckets_len;         /* Power of two */
+    size_t          *fd_table;              /* Client index + 1 of an active fd or 0 */
+    size_t          fd_table_len;
+    size_t          queue_limit;            /* Max outbound queued bytes of a client */
+    topic_table_t   *topic_table;           /* Topic to subscribers index */
 } client_vec_t;
 
 /**
@@ -80,9 +103,10 @@ typedef struct client_vec_s {
  *
  * @param clients pointer to vector structure to allocate must be NULL.
  * @param init_clients initial vector length to allocate.
+ * @param queue_limit max number of outbound bytes queued for a client.
  * @return err_t OK if vector could be allocated, error otherwise.
  */
-err_t create_clients_vec(client_vec_t **clients, size_t init_clients);
+err_t create_clients_vec(client_vec_t **clients, size_t init_clients, size_t queue_limit);
 
 /**
  * @brief Frees a clients vector object
@@ -104,9 +128,23 @@ err_t free_clients_vec(client_vec_t **clients);
  * @param clients clients vector structure.
  * @param client_id id of the client to register.
  * @param client_fd valid socket file descripor assigned for the client.
+ * @param client_proto wire format spoken by the client.
+ * @param client_idx pointer to variable to set the index of the registered client.
  * @return err_t OK if client was registered successfully or error otherwise.
  */
-err_t register_new_client(client_vec_t *clients, char *client_id, int client_fd);
+err_t register_new_client(client_vec_t *clients, char *client_id, int client_fd,
+    tcp_proto_t client_proto, size_t *client_idx);
+
+/**
+ * @brief Restores a DEAD client without any connection, if the
+ * client is already registered just its index is returned.
+ *
+ * @param clients clients vector structure.
+ * @param client_id id of the client to restore.
+ * @param client_idx pointer to variable to set the index of the client.
+ * @return err_t OK if the client was restored or error otherwise.
+ */
+err_t restore_client(client_vec_t *clients, const char *client_id, size_t *client_idx);
 
 /**
  * @brief Assigns to a client a DEAD status and sets the socket file
@@ -134,7 +172,7 @@ const char* get_client_id(client_vec_t *clients, size_t client_idx);
 /**
  * @brief Adds a new topic and a new option for the selected topic
  * for the specified client, the client is found over its valid socket
- * file descriptor.
+ * file descriptor. The topic index is updated with the new subscriber.
  *
  * @param clients clients vector structure.
  * @param client_fd valid socket file descriptor assigned for the client.
@@ -144,9 +182,23 @@ const char* get_client_id(client_vec_t *clients, size_t client_idx);
  */
 err_t subscribe_client_to_topic(client_vec_t *clients, int client_fd, char *client_topic, client_options_t client_sf);
 
+/**
+ * @brief Adds a new topic and a new option for the selected topic
+ * for the client found over its index, the client can be DEAD.
+ *
+ * @param clients clients vector structure.
+ * @param client_idx valid client index.
+ * @param client_topic string topic name to add.
+ * @param client_sf enum option class for the specified topic name.
+ * @return err_t OK if the topic was addded successfully or error otherwise.
+ */
+err_t subscribe_client_idx_to_topic(client_vec_t *clients, size_t client_idx,
+    const char *client_topic, client_options_t client_sf);
+
 /**
  * @brief Removes a topic and it's option for the specified client, the
- * client is found over its valid socket file descriptor.
+ * client is found over its valid socket file descriptor. The client is
+ * removed from the subscribers of the topic index.
  *
  * @param clients clients vector structure.
  * @param client_fd valid socket file descriptor assigned for the client.
@@ -155,18 +207,41 @@ err_t subscribe_client_to_topic(client_vec_t *clients, int client_fd, char *clie
  */
 err_t unsubscribe_client_from_topic(client_vec_t *clients, int client_fd, char *client_topic);
 
+/**
+ * @brief Removes a topic and it's option for the client found
+ * over its index, the client can be DEAD.
+ *
+ * @param clients clients vector structure.
+ * @param client_idx valid client index.
+ * @param client_topic string topic name to remove
+ * @return err_t OK if the topic was removed successfully or error otherwise.
+ */
+err_t unsubscribe_client_idx_from_topic(client_vec_t *clients, size_t client_idx, const char *client_topic);
+
 /**
  * @brief Stackes a UDP message for a client. The client
  * stores unsent messages opon Store and Forward functionality.
+ * The client holds a reference of the shared frame.
  *
  * The client is found over his index to generate a O(1) search
  * for fast time response.
  *
  * @param clients clients vector structure.
- * @param udp_msg UDP message to store in the queue.
+ * @param frame shared frame of the UDP message to store in the queue.
  * @param client_idx valid client index in order to find the client.
  * @return err_t OK if the message wasa stacked successfully or error otherwsie
  */
-err_t add_topic_msg_for_client(client_vec_t *clients, udp_type_t *udp_msg, size_t client_idx);
+err_t add_topic_msg_for_client(client_vec_t *clients, tcp_frame_t *frame, size_t client_idx);
+
+/**
+ * @brief Drops the oldest stacked UDP messages of a client,
+ * the client releases its references of the shared frames.
+ *
+ * @param clients clients vector structure.
+ * @param msgs number of messages to drop.
+ * @param client_idx valid client index in order to find the client.
+ * @return err_t OK if the messages were dropped or error otherwise.
+ */
+err_t drop_topic_msgs_for_client(client_vec_t *clients, size_t msgs, size_t client_idx);
 
 #endif /* CLIENT_VEC_H_ */
@@ -0,0 +1,213 @@
+/**
+ * @file journal.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include "./utils.h"
+#include "./tcp_type.h"
+#include "./client_vec.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define JOURNAL_MAGIC               0x4c4e524a  /* "JRNL" */
+#define JOURNAL_VERSION             1
+#define JOURNAL_GROW_BYTES          (4 * 1024 * 1024)
+#define JOURNAL_REC_ALIGN           sizeof (uint64_t)
+#define JOURNAL_INIT_RECIPIENTS     64
+#define DEFAULT_JOURNAL_SYNC_MS     50
+
+/**
+ * @brief Enum class type of the journal records.
+ *
+ */
+typedef enum journal_rec_type_s {
+    JOURNAL_END         = 0,        /* Unwritten space */
+    JOURNAL_CLIENT      = 1,        /* New client, id */
+    JOURNAL_SUBSCRIBE   = 2,        /* Client index, sf option, topic */
+    JOURNAL_UNSUBSCRIBE = 3,        /* Client index, topic */
+    JOURNAL_FRAME       = 4,        /* Number of clients, client indexes, frame data */
+    JOURNAL_CONSUME     = 5         /* Client index, number of messages */
+} journal_rec_type_t;
+
+/**
+ * @brief Header at the start of a journal file.
+ *
+ */
+typedef struct journal_header_s {
+    uint32_t    magic;
+    uint32_t    version;
+    uint64_t    reserved;
+} journal_header_t;
+
+/**
+ * @brief Header of a journal record, followed by len data bytes
+ * and padded to JOURNAL_REC_ALIGN bytes. The checksum covers the
+ * length, the type and the data, so a torn record ends the replay.
+ *
+ */
+typedef struct journal_rec_s {
+    uint32_t    sum;                        /* FNV-1a of the record */
+    uint32_t    len;                        /* Data bytes */
+    uint8_t     type;                       /* journal_rec_type_t value */
+    uint8_t     reserved[7];
+    uint8_t     data[];
+} journal_rec_t;
+
+/**
+ * @brief Counters of the journal activity.
+ *
+ */
+typedef struct journal_stats_s {
+    uint64_t    records;                    /* Appended records */
+    uint64_t    bytes;                      /* Appended bytes */
+    uint64_t    syncs;                      /* Flushes of the appended records */
+    uint64_t    replayed_records;           /* Records applied on startup */
+    uint64_t    replayed_frames;            /* Backlog messages restored on startup */
+} journal_stats_t;
+
+/**
+ * @brief Struct class type of an append-only journal mapped in
+ * memory. The journal keeps the clients, their subscriptions and
+ * their store-and-forward backlogs, the records are flushed to
+ * the disk in groups at most sync_ms apart.
+ *
+ */
+typedef struct journal_s {
+    int                 fd;
+    uint8_t             *map;
+    size_t              map_len;
+    size_t              used;               /* Header and records bytes */
+    size_t              synced;             /* Bytes already flushed */
+    uint64_t            sync_ms;
+    uint64_t            last_sync_ms;
+    uint32_t            *recipients;        /* Backlogs of the next frame record */
+    size_t              recipients_len;
+    size_t              recipients_capacity;
+    journal_stats_t     stats;
+} journal_t;
+
+/**
+ * @brief Opens a journal file and replays it into an empty clients
+ * vector, all the restored clients are DEAD. The journal is then
+ * compacted into a new file with just the live state.
+ *
+ * @param journal pointer to journal structure to allocate, must be NULL.
+ * @param path path of the journal file, created if missing.
+ * @param sync_ms max delay in ms of a record flush, 0 flushes on every sync call.
+ * @param clients clients vector to restore.
+ * @return err_t OK if the journal was opened or error otherwise.
+ */
+err_t open_journal(journal_t **journal, const char *path, uint64_t sync_ms, client_vec_t *clients);
+
+/**
+ * @brief Flushes and closes a journal and sets it to NULL.
+ *
+ * @param journal pointer to journal structure.
+ * @return err_t OK if the journal was closed or error otherwise.
+ */
+err_t close_journal(journal_t **journal);
+
+/**
+ * @brief Appends a new client, the clients are restored in the
+ * order of their records so the client indexes stay the same.
+ *
+ * @param journal journal structure.
+ * @param client_id id of the new client.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_client(journal_t *journal, const char *client_id);
+
+/**
+ * @brief Appends a subscription of a client.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @param topic topic name.
+ * @param sf store and forward option.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_subscribe(journal_t *journal, size_t client_idx, const char *topic, client_options_t sf);
+
+/**
+ * @brief Appends an unsubscription of a client.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @param topic topic name.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_unsubscribe(journal_t *journal, size_t client_idx, const char *topic);
+
+/**
+ * @brief Adds a client whose backlog got the next frame.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @return err_t OK if the client was added or error otherwise.
+ */
+err_t journal_add_recipient(journal_t *journal, size_t client_idx);
+
+/**
+ * @brief Appends a frame stacked in the backlogs of the added
+ * recipients, nothing is appended if there are no recipients.
+ *
+ * @param journal journal structure.
+ * @param frame shared frame of the message.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_frame(journal_t *journal, tcp_frame_t *frame);
+
+/**
+ * @brief Appends the number of messages taken from the
+ * front of a client backlog.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @param msgs number of messages.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_consume(journal_t *journal, size_t client_idx, size_t msgs);
+
+/**
+ * @brief Gets the time until the appended records must be flushed.
+ *
+ * @param journal journal structure.
+ * @return int timeout in ms or -1 if there is nothing to flush.
+ */
+int journal_sync_timeout(journal_t *journal);
+
+/**
+ * @brief Flushes the appended records if the sync delay passed.
+ *
+ * @param journal journal structure.
+ * @param force 1 to flush regardless of the delay.
+ * @return err_t OK if the records are flushed or not due yet, error otherwise.
+ */
+err_t journal_sync(journal_t *journal, uint8_t force);
+
+#endif /* JOURNAL_H_ */
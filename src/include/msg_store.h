@@ -0,0 +1,163 @@
+/**
+ * @file msg_store.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MSG_STORE_H_
+#define MSG_STORE_H_
+
+#include "./utils.h"
+#include "./udp_type.h"
+
+#include <time.h>
+
+#define MSG_STORE_SEGMENT_BYTES         (64 * 1024)
+#define MSG_STORE_INIT_SEGMENTS         8
+#define MSG_STORE_INIT_RECORDS          1024
+#define MSG_STORE_MAX_FREE_SEGMENTS     2
+
+/* Zero means the retention is not limited by that criterion */
+#define DEFAULT_RETAIN_MSGS             0
+#define DEFAULT_RETAIN_BYTES            (size_t)(16 * 1024 * 1024)
+#define DEFAULT_RETAIN_AGE              0
+
+/**
+ * @brief Fixed size arena of variable size records, the records are
+ * appended one after another and a segment is recycled as a whole
+ * when all its records expired.
+ *
+ */
+typedef struct msg_segment_s {
+    struct msg_segment_s    *next;          /* Next recycled segment */
+    size_t                  used;           /* Bytes of the appended records */
+    size_t                  live;           /* Records not expired yet */
+    uint64_t                arena[MSG_STORE_SEGMENT_BYTES / sizeof (uint64_t)];
+} msg_segment_t;
+
+/**
+ * @brief Struct class type containing the
+ * counters of the message store.
+ *
+ */
+typedef struct msg_store_stats_s {
+    uint64_t    appended;                   /* Stored messages */
+    uint64_t    expired;                    /* Messages dropped by the retention */
+    uint64_t    record_bytes;               /* Bytes of the retained records */
+    uint64_t    segments_allocated;         /* Segments allocated with malloc */
+    uint64_t    segments_recycled;          /* Segments reused from the free list */
+} msg_store_stats_t;
+
+/**
+ * @brief Segmented store of the received udp messages. The records
+ * are appended in the arena of the newest segment and expire from the
+ * oldest one, every message is addressed by its sequence number. A
+ * record never moves in memory while it is retained.
+ *
+ */
+typedef struct msg_store_s {
+    msg_segment_t       **segments;         /* Ring of live segments, oldest first */
+    size_t              seg_head;
+    size_t              seg_len;
+    size_t              seg_capacity;
+    udp_record_t        **records;          /* Ring of retained records, oldest first */
+    size_t              rec_head;
+    size_t              len;                /* Retained messages */
+    size_t              rec_capacity;
+    uint64_t            first_seq;          /* Sequence number of the oldest message */
+    msg_segment_t       *free_segs;         /* Expired segments kept for reuse */
+    size_t              free_len;
+    size_t              max_msgs;           /* Retention by number of messages */
+    size_t              max_bytes;          /* Retention by memory of the live segments */
+    uint64_t            max_age_ms;         /* Retention by age of the messages */
+    msg_store_stats_t   stats;
+} msg_store_t;
+
+/**
+ * @brief Creates an empty message store.
+ *
+ * @param store pointer to store structure to allocate, must be NULL.
+ * @param max_msgs max number of retained messages or 0.
+ * @param max_bytes max bytes of the live segments or 0.
+ * @param max_age_ms max age of a retained message in ms or 0.
+ * @return err_t OK if the store was allocated or error otherwise.
+ */
+err_t create_msg_store(msg_store_t **store, size_t max_msgs, size_t max_bytes, uint64_t max_age_ms);
+
+/**
+ * @brief Frees a message store and sets it to NULL.
+ *
+ * @param store pointer to store structure.
+ * @return err_t OK if the store was freed or error otherwise.
+ */
+err_t free_msg_store(msg_store_t **store);
+
+/**
+ * @brief Gets room for a record after the newest message, at least
+ * UDP_RECORD_MAX_LEN bytes, so a message can be parsed in place. The
+ * record becomes a stored message just after msg_store_commit, so a
+ * record that could not be filled is reused by the next call.
+ *
+ * @param store store structure.
+ * @param record pointer to variable to set the record.
+ * @return err_t OK if a record is available or error otherwise.
+ */
+err_t msg_store_reserve(msg_store_t *store, udp_record_t **record);
+
+/**
+ * @brief Stores the record got by the last msg_store_reserve call,
+ * the record takes just its udp_record_size bytes of the arena.
+ *
+ * @param store store structure.
+ * @param seq pointer to variable to set the sequence number of the message or NULL.
+ * @return err_t OK if the record was stored or error otherwise.
+ */
+err_t msg_store_commit(msg_store_t *store, uint64_t *seq);
+
+/**
+ * @brief Gets a retained message by its sequence number.
+ *
+ * @param store store structure.
+ * @param seq sequence number of the message.
+ * @param record pointer to variable to set the record.
+ * @return err_t OK if the message is retained or MSG_STORE_SEQ_NOT_FOUND otherwise.
+ */
+err_t msg_store_get(msg_store_t *store, uint64_t seq, udp_record_t **record);
+
+/**
+ * @brief Gets the sequence number of the next stored message.
+ *
+ * @param store store structure.
+ * @return uint64_t next sequence number.
+ */
+uint64_t msg_store_next_seq(msg_store_t *store);
+
+/**
+ * @brief Drops the oldest messages while the store is over one of its
+ * retention limits. The expired segments are recycled. The messages
+ * still referenced by a store-and-forward backlog are kept alive by
+ * their shared frames, not by the store.
+ *
+ * @param store store structure.
+ */
+void msg_store_expire(msg_store_t *store);
+
+#endif /* MSG_STORE_H_ */
@@ -26,17 +26,95 @@
 #define POLL_VEC_H_
 
 #include "./utils.h"
+#include "./uring.h"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+
+#define INIT_POLL_VEC_SLOTS     64
+#define POLL_VEC_URING_EVENTS   256             /* Completions reaped by one wait, at least */
+
+/**
+ * @brief Enum class type to select the
+ * IO multiplexing mechanism behind a poll vector.
+ *
+ */
+typedef enum poll_vec_backend_s {
+    POLL_BACKEND    = 0,
+    EPOLL_BACKEND   = 1,
+    URING_BACKEND   = 2
+} poll_vec_backend_t;
+
+/**
+ * @brief Enum class type of the io_uring operations
+ * reported in the ready list.
+ *
+ */
+typedef enum poll_vec_op_s {
+    POLL_VEC_OP_POLL    = 0,    /* Readiness of a watched fd */
+    POLL_VEC_OP_ACCEPT  = 1,    /* Multishot accept, res is the new fd */
+    POLL_VEC_OP_RECVMSG = 2,    /* Multishot receive into a provided buffer */
+    POLL_VEC_OP_SENDMSG = 3,    /* Send, res is the number of sent bytes */
+    POLL_VEC_OP_CANCEL  = 4     /* Removal of a watched fd, never reported */
+} poll_vec_op_t;
+
+/**
+ * @brief Struct class defining a ready file
+ * descriptor after a wait call, the user data
+ * is the pointer registered together with the fd.
+ * The io_uring backend reports the completed operations
+ * of the fd in the same list.
+ *
+ */
+typedef struct poll_vec_event_s {
+    int         fd;
+    short       revents;
+    void        *data;
+    uint8_t     op;             /* POLL_VEC_OP_POLL for a readiness event */
+    int32_t     res;            /* Result of a completed operation */
+    uint32_t    flags;          /* Completion flags of a completed operation */
+} poll_vec_event_t;
+
+/**
+ * @brief Struct class defining the metadata of
+ * a watched file descriptor, indexed directly by fd.
+ *
+ */
+typedef struct poll_vec_slot_s {
+    uint8_t     used;
+    short       events;
+    nfds_t      idx;            /* Index in the pfds array for the poll backend */
+    void        *data;          /* User data returned on every ready event */
+    uint32_t    gen;            /* Tells the completions of a reused fd apart */
+} poll_vec_slot_t;
 
 /**
  * @brief Struct class defining a vector
  * of pollfds, in order to mantain a dynamic
  * behaviour of IO multiplexing.
  *
+ * The poll backend scans the whole pfds array on every
+ * wakeup, the epoll backend reports just the ready fds.
+ * The io_uring backend arms a one-shot poll for every
+ * watched fd again after it fires, so the readiness is level
+ * triggered, and it runs the operations submitted for the watched
+ * fds. All the backends fill the same ready list.
+ *
  */
 typedef struct poll_vec_s {
-    struct pollfd   *pfds;
-    nfds_t          nfds;
-    nfds_t          capacity;
+    poll_vec_backend_t  backend;
+    struct pollfd       *pfds;
+    nfds_t              nfds;
+    nfds_t              capacity;
+    poll_vec_slot_t     *slots;         /* Watched fds metadata indexed by fd */
+    size_t              slots_len;
+    int                 epfd;           /* Epoll instance for the epoll backend */
+    struct epoll_event  *epoll_events;
+    uring_t             *uring;         /* Io_uring instance for the io_uring backend */
+    uint32_t            gen;            /* Generation of the last added fd */
+    poll_vec_event_t    *ready;         /* Ready fds after the last wait call */
+    nfds_t              nready;
+    nfds_t              ready_capacity;
 } poll_vec_t;
 
 /**
@@ -49,6 +127,17 @@ typedef struct poll_vec_s {
  */
 err_t create_poll_vec(poll_vec_t **vec, nfds_t init_nfds);
 
+/**
+ * @brief Creates a poll vector with the selected backend
+ * and links it to the input poll vector pointer.
+ *
+ * @param vec pointer to a NULL poll vector.
+ * @param init_nfds init capacity for the poll vector.
+ * @param backend IO multiplexing backend.
+ * @return err_t OK if poll vector was allocated successfully or error otherwise.
+ */
+err_t create_poll_vec_with(poll_vec_t **vec, nfds_t init_nfds, poll_vec_backend_t backend);
+
 /**
  * @brief Frees a poll vector and assigns it to NULL pointer.
  *
@@ -68,6 +157,50 @@ err_t free_poll_vec(poll_vec_t **vec);
  */
 err_t poll_vec_add_fd(poll_vec_t *vec, int fd, short fd_events);
 
+/**
+ * @brief Adds a new valid file descriptor to the poll vector
+ * together with an user data pointer returned on every ready event.
+ *
+ * @param vec poll vector structure.
+ * @param fd new valid file descriptor.
+ * @param fd_events file descriptor events.
+ * @param data user data pointer, can be NULL.
+ * @return err_t OK if file descriptor was added successfully or error otherwise.
+ */
+err_t poll_vec_add_fd_data(poll_vec_t *vec, int fd, short fd_events, void *data);
+
+/**
+ * @brief Adds a copy of a file descriptor owned by another structure,
+ * the poll vector closes just the copy.
+ *
+ * @param vec poll vector structure.
+ * @param fd valid file descriptor to copy.
+ * @param fd_events file descriptor events.
+ * @param dup_fd pointer to variable to set the watched copy.
+ * @return err_t OK if the copy was added successfully or error otherwise.
+ */
+err_t poll_vec_add_fd_dup(poll_vec_t *vec, int fd, short fd_events, int *dup_fd);
+
+/**
+ * @brief Changes the user data pointer of a watched file descriptor.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor.
+ * @param data new user data pointer.
+ * @return err_t OK if the data was changed or error otherwise.
+ */
+err_t poll_vec_set_fd_data(poll_vec_t *vec, int fd, void *data);
+
+/**
+ * @brief Changes the events of a watched file descriptor.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor.
+ * @param fd_events new file descriptor events.
+ * @return err_t OK if the events were changed or error otherwise.
+ */
+err_t poll_vec_modify_fd(poll_vec_t *vec, int fd, short fd_events);
+
 /**
  * @brief Removes a file descriptor from the poll vector at a specified
  * index, the index should be valid or function will return with error.
@@ -78,4 +211,64 @@ err_t poll_vec_add_fd(poll_vec_t *vec, int fd, short fd_events);
  */
 err_t poll_vec_remove_fd(poll_vec_t *vec, nfds_t fd_idx);
 
+/**
+ * @brief Removes and closes a watched file descriptor in O(1),
+ * pending ready events of the fd are discarded and the pending
+ * io_uring operations of the fd are cancelled.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor.
+ * @return err_t OK if file descriptor was removed or error otherwise.
+ */
+err_t poll_vec_remove_fd_by(poll_vec_t *vec, int fd);
+
+/**
+ * @brief Waits for events on the watched file descriptors and
+ * fills the ready list of the poll vector.
+ *
+ * @param vec poll vector structure.
+ * @param timeout timeout in milliseconds or -1 to block.
+ * @return err_t OK if the wait returned (nready can be 0 on timeout)
+ * or POLL_FAILED_TIMED_OUT if the wait failed.
+ */
+err_t poll_vec_wait(poll_vec_t *vec, int timeout);
+
+/**
+ * @brief Starts a multishot accept on a watched listener socket, every
+ * accepted connection is reported as a POLL_VEC_OP_ACCEPT event. The accept
+ * must be started again when an event comes without IORING_CQE_F_MORE.
+ * Just the io_uring backend runs operations.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched listener socket.
+ * @return err_t OK if the accept was queued or error otherwise.
+ */
+err_t poll_vec_accept(poll_vec_t *vec, int fd);
+
+/**
+ * @brief Starts a multishot receive on a watched socket, every message
+ * is received in a provided buffer of the io_uring instance and reported
+ * as a POLL_VEC_OP_RECVMSG event. The buffer must be released after the
+ * event is processed and the receive must be started again when an event
+ * comes without IORING_CQE_F_MORE.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched socket.
+ * @param hdr lengths of the address and control parts of every buffer.
+ * @return err_t OK if the receive was queued or error otherwise.
+ */
+err_t poll_vec_recvmsg(poll_vec_t *vec, int fd, struct msghdr *hdr);
+
+/**
+ * @brief Queues a send on a watched socket, it is submitted by the next
+ * wait call and reported as a POLL_VEC_OP_SENDMSG event. The message
+ * buffers must be kept until the event.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched socket.
+ * @param hdr message to send.
+ * @return err_t OK if the send was queued or error otherwise.
+ */
+err_t poll_vec_sendmsg(poll_vec_t *vec, int fd, struct msghdr *hdr);
+
 #endif /* POLL_VEC_H_ */
@@ -0,0 +1,89 @@
+/**
+ * @file server_config.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SERVER_CONFIG_H_
+#define SERVER_CONFIG_H_
+
+#include "./utils.h"
+#include "./poll_vec.h"
+#include "./udp_batch.h"
+#include "./msg_store.h"
+#include "./journal.h"
+
+#include <getopt.h>
+
+#define DEFAULT_BACKEND         EPOLL_BACKEND
+#define DEFAULT_QUEUE_LIMIT     (size_t)(256 * 1024)
+#define DEFAULT_OVERFLOW        OVERFLOW_SPILL
+#define DEFAULT_WORKERS         1
+#define MAX_WORKERS             64                  /* One interest bit of the match stage per shard */
+
+/**
+ * @brief Enum type class to handle what happens with a new
+ * message when the outbound queue of a slow client is full.
+ *
+ */
+typedef enum overflow_policy_s {
+    OVERFLOW_DROP_OLDEST    = 0,    /* Drop the oldest queued frames */
+    OVERFLOW_DISCONNECT     = 1,    /* Disconnect the slow client */
+    OVERFLOW_SPILL          = 2     /* Keep the message in the store-and-forward backlog */
+} overflow_policy_t;
+
+/**
+ * @brief Structure type class containing the
+ * server startup options parsed from the command line.
+ *
+ */
+typedef struct server_config_s {
+    uint16_t            port;               /* UDP and TCP listening port */
+    poll_vec_backend_t  backend;            /* IO multiplexing backend */
+    size_t              udp_batch_len;      /* Datagrams received by one recvmmsg call */
+    size_t              udp_drain_limit;    /* Datagrams received on one wakeup */
+    size_t              queue_limit;        /* Outbound queued bytes of one client */
+    overflow_policy_t   overflow;           /* Policy for a full outbound queue */
+    size_t              retain_msgs;        /* Retained udp messages, 0 if unlimited */
+    size_t              retain_bytes;       /* Memory of the retained messages, 0 if unlimited */
+    size_t              retain_age;         /* Seconds a message is retained, 0 if unlimited */
+    const char          *journal_path;      /* Persistent journal file or NULL */
+    size_t              journal_sync;       /* Max ms between journal flushes */
+    size_t              workers;            /* Event loop threads owning the subscribers */
+} server_config_t;
+
+/**
+ * @brief Parses the server command line into a config structure,
+ * the options that are not present keep their default values.
+ *
+ * Usage: ./server <port> [--backend poll|epoll|uring] [--udp-batch N] [--udp-drain N]
+ *                       [--queue-limit BYTES] [--overflow drop-oldest|disconnect|spill]
+ *                       [--retain-msgs N] [--retain-bytes BYTES] [--retain-age SECONDS]
+ *                       [--journal FILE] [--journal-sync MS] [--workers N]
+ *
+ * @param config pointer to config structure to fill.
+ * @param argc number of command line arguments.
+ * @param argv command line arguments.
+ * @return err_t OK if the command line is valid or SERVER_INVALID_CONFIG otherwise.
+ */
+err_t parse_server_config(server_config_t *config, int argc, char **argv);
+
+#endif /* SERVER_CONFIG_H_ */
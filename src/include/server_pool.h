@@ -0,0 +1,148 @@
+/**
+ * @file server_pool.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SERVER_POOL_H_
+#define SERVER_POOL_H_
+
+#include "./server_utils.h"
+
+#define INIT_POOL_DIRECTORY_LEN     64
+#define INIT_POOL_INTEREST_LEN      64
+
+/**
+ * @brief Entry of the client ID directory, maps a client
+ * ID to the worker shard that owns the client record.
+ *
+ */
+typedef struct pool_client_s {
+    char        *id;                    /* Client ID or NULL if the slot is free */
+    uint64_t    hash;
+    size_t      shard_id;
+} pool_client_t;
+
+/**
+ * @brief Struct class type of the match stage, it routes every
+ * udp record to the worker shards with subscribers of its topic.
+ *
+ */
+typedef struct pool_match_s {
+    pthread_t           thread;
+    uint8_t             running;
+    shard_inbox_t       *inbox;             /* Interest updates and control messages */
+    poll_vec_t          *poll_vec;          /* Ingest ring and inbox eventfds */
+    int                 ring_fd;            /* Watched copy of the ingest ring eventfd */
+    int                 inbox_fd;           /* Watched copy of the inbox eventfd */
+    topic_table_t       *topics;            /* Every topic seen by the match stage */
+    uint64_t            *interest;          /* Bit mask of the interested shards per topic id */
+    size_t              interest_len;
+    uint64_t            routed;             /* Records copied to a shard ring */
+    uint64_t            unmatched;          /* Records without interested shards */
+    stage_stats_t       stage;
+} pool_match_t;
+
+/**
+ * @brief Struct class type of a pool of worker shards running a staged
+ * pipeline, every stage runs on its own thread:
+ *
+ * - ingest: the dispatcher owns the UDP socket and the stdin, it parses
+ * every datagram into a udp record in the ingest ring.
+ * - match: routes every record to the rings of the interested shards.
+ * - egress: every worker shard renders and sends the records to its
+ * subscribers, the shards accept the TCP connections on their own
+ * SO_REUSEPORT listener.
+ *
+ * The stages are connected by single producer, single consumer rings.
+ *
+ */
+typedef struct server_pool_s {
+    server_config_t     config;             /* Startup options */
+    size_t              workers;            /* Number of worker shards */
+    server_t            **shards;           /* Worker shards */
+    pthread_t           *threads;           /* Event loop thread of every shard */
+    size_t              running;            /* Started worker threads */
+    int                 udp_socket;         /* UDP socket to get udp messages */
+    udp_batch_t         *udp_batch;         /* Datagram slots to ingest udp messages */
+    spsc_ring_t         *ring;              /* Parsed udp records for the match stage */
+    stage_stats_t       stage;              /* Ingest stage counters */
+    pool_match_t        match;              /* Match stage */
+    poll_vec_t          *poll_vec;          /* Stdin, UDP socket and done eventfd */
+    int                 done_fd;            /* Signalled by a stopped stage thread */
+    int                 done_watch_fd;      /* Watched copy of the done eventfd */
+    char                *cmd;               /* Buffer to process user input commands */
+    pthread_mutex_t     lock;               /* Guards the client ID directory */
+    pool_client_t       *directory;         /* Owner shard of every known client ID */
+    size_t              directory_len;
+    size_t              directory_used;
+    uint64_t            handoffs;           /* Clients handed off to their owner shard */
+} server_pool_t;
+
+/**
+ * @brief Runs the server with a pool of worker threads until the
+ * exit command is received or a stage thread stops.
+ *
+ * @param config startup options containing a valid port number.
+ * @return err_t OK if the pool ran and stopped successfully or error otherwise.
+ */
+err_t run_server_pool(const server_config_t *config);
+
+/**
+ * @brief Gets the worker shard that owns a client ID, a new
+ * client ID is owned by the claiming shard.
+ *
+ * @param pool pool structure.
+ * @param id client ID.
+ * @param shard_id index of the claiming shard.
+ * @param owner pointer to variable to set the index of the owner shard.
+ * @return err_t OK if the owner was found or error otherwise.
+ */
+err_t server_pool_claim_client(server_pool_t *pool, const char *id, size_t shard_id, size_t *owner);
+
+/**
+ * @brief Posts a client that completed its handshake to the inbox
+ * of its owner shard, the owner shard registers the client.
+ *
+ * @param pool pool structure.
+ * @param owner index of the owner shard.
+ * @param fd socket of the client.
+ * @param proto wire format of the client.
+ * @param id client ID.
+ * @param addr address of the client.
+ * @return err_t OK if the client was posted or error otherwise.
+ */
+err_t server_pool_handoff_client(server_pool_t *pool, size_t owner, int fd, tcp_proto_t proto,
+    const char *id, const struct sockaddr_in *addr);
+
+/**
+ * @brief Tells the match stage whether a worker shard has
+ * subscribers of a topic.
+ *
+ * @param pool pool structure.
+ * @param shard_id index of the worker shard.
+ * @param topic topic name.
+ * @param interest 1 if the shard has subscribers of the topic or 0 otherwise.
+ * @return err_t OK if the update was posted or error otherwise.
+ */
+err_t server_pool_post_interest(server_pool_t *pool, size_t shard_id, const char *topic, uint8_t interest);
+
+#endif /* SERVER_POOL_H_ */
@@ -30,32 +30,69 @@
 #include "./udp_type.h"
 #include "./tcp_type.h"
 #include "./client_vec.h"
+#include "./server_config.h"
+#include "./shard_inbox.h"
+#include "./spsc_ring.h"
+
+#include <fcntl.h>
 
-#define MAX_SERVER_BUFLEN       8096
 #define MAX_LISTEN_SOCKET       10
 
 #define INIT_NFDS               (nfds_t)10
 #define INIT_CLIENTS            10
-#define INIT_UDP_MSGS_LEN       20
+
+/* Provided buffers of the io_uring backend, a datagram follows its address */
+#define URING_UDP_BUFS          256
+#define URING_UDP_BUF_LEN       (sizeof (struct io_uring_recvmsg_out) + sizeof (struct sockaddr_in) + UDP_SLOT_LEN)
 
 #define EXIT_CMD                "exit\0"
 #define EXIT_CMD_LEN            strlen(EXIT_CMD)
 
+#define STATS_CMD               "stats\0"
+#define STATS_CMD_LEN           strlen(STATS_CMD)
+
+/**
+ * @brief Counters of the client outbound queues.
+ *
+ */
+typedef struct queue_stats_s {
+    uint64_t    queued_frames;          /* Frames the socket could not take right away */
+    uint64_t    pollout_wakeups;        /* Wakeups to flush an outbound queue */
+    uint64_t    max_queued_bytes;       /* Largest outbound queue seen */
+    uint64_t    dropped_frames;         /* Frames dropped by the drop-oldest policy */
+    uint64_t    spilled_msgs;           /* Messages spilled in the store-and-forward backlog */
+    uint64_t    overflow_disconnects;   /* Clients disconnected by the disconnect policy */
+} queue_stats_t;
+
+struct server_pool_s;
+
 typedef struct server_s {
+    server_config_t         config;             /* Startup options */
     int                     udp_socket;         /* UDP socket to get udp messages */
     int                     tcp_socket;         /* Listener tcp socket for subscribers */
     struct sockaddr_in      udp_addr;
     struct sockaddr_in      tcp_addr;
-    struct sockaddr_in      udp_addr_client;
     poll_vec_t              *poll_vec;          /* Poll vector with all active fds */
-    char                    *buf;               /* Buffer to process udp messages */
+    udp_batch_t             *udp_batch;         /* Datagram slots to ingest udp messages */
+    struct msghdr           udp_hdr;            /* Layout of the io_uring datagram buffers */
+    client_type_t           **send_list;        /* Clients to send to after this wakeup */
+    size_t                  send_list_len;
+    size_t                  send_list_capacity;
+    queue_stats_t           queue_stats;        /* Outbound queues counters */
     char                    *cmd;               /* Buffer to process user input commands */
     tcp_msg_t               *send_msg;          /* Encapsulated TCP msg protocol for sending */
     tcp_msg_t               *recv_msg;          /* Encapsulated TCP msg protocol for receiving */
     client_vec_t            *clients;           /* Clients vector containg all clients metadata */
-    udp_type_t              *udp_msgs;          /* Available udp type class containg topics */
-    size_t                  udp_msgs_len;
-    size_t                  udp_msgs_capacity;
+    msg_store_t             *msg_store;         /* Retained udp messages */
+    journal_t               *journal;           /* Persistent clients state or NULL */
+    struct server_pool_s    *pool;              /* Pool of the worker shard or NULL */
+    size_t                  shard_id;           /* Index of the worker shard */
+    shard_inbox_t           *inbox;             /* Control messages for the worker shard or NULL */
+    int                     inbox_fd;           /* Watched copy of the inbox eventfd */
+    spsc_ring_t             *ring;              /* Matched udp records for the worker shard or NULL */
+    int                     ring_fd;            /* Watched copy of the ring eventfd */
+    stage_stats_t           stage;              /* Egress stage counters of the worker shard */
+    uint8_t                 stopped;            /* The worker shard got an exit message */
 } server_t;
 
 /**
@@ -63,11 +100,27 @@ typedef struct server_s {
  *
  *
  * @param server pointer to server structure, MUST be NULL.
- * @param hport a valid port number to open the connection.
+ * @param config startup options containing a valid port number.
  * @return err_t OK if the server was allocated and initialized successfully or
  * error otherwise.
  */
-err_t init_server(server_t **server, const uint16_t hport);
+err_t init_server(server_t **server, const server_config_t *config);
+
+/**
+ * @brief Inits a worker shard of a server pool. The shard has no UDP
+ * socket and does not read the stdin, it gets the parsed udp records
+ * matching its subscriptions from its ring. Its TCP listener shares the port with the other shards through
+ * SO_REUSEPORT and its journal file gets the ".<shard_id>" suffix.
+ *
+ * @param server pointer to server structure, MUST be NULL.
+ * @param config startup options containing a valid port number.
+ * @param pool pool of the worker shard.
+ * @param shard_id index of the worker shard.
+ * @return err_t OK if the shard was allocated and initialized successfully or
+ * error otherwise.
+ */
+err_t init_server_shard(server_t **server, const server_config_t *config,
+    struct server_pool_s *pool, size_t shard_id);
 
 /**
  * @brief Frees the resources allocated by the server and closes all the connections
@@ -82,7 +135,8 @@ err_t free_server(server_t **server);
 /**
  * @brief Poll the available fds, the poll timeout is set to -1.
  * If the function returns with POLL_FAILED_TIMED_OUT the connection
- * is wrong or the fds is unavilable.
+ * is wrong or the fds is unavilable. Just the ready fds are saved
+ * in the ready list of the poll vector.
  *
  * @param this server structure.
  * @return err_t OK if atleast one fd is available for specified events.
@@ -108,11 +162,19 @@ err_t process_ready_fds(server_t *this);
 
 /**
  * @brief Receives an input command from the stdin and processes it
- * by checking if the command is exit.
+ * by checking if the command is exit. The stats command prints the
+ * server counters.
  *
  * @param this server structure.
  * @return uint8_t 1 if command is exit or 0 otherwise.
  */
 uint8_t check_if_exit(server_t *this);
 
+/**
+ * @brief Prints the server counters on the stdout.
+ *
+ * @param this server structure.
+ */
+void print_server_stats(server_t *this);
+
 #endif /* SERVER_UTILS_H_ */
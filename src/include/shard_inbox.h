@@ -0,0 +1,152 @@
+/**
+ * @file shard_inbox.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHARD_INBOX_H_
+#define SHARD_INBOX_H_
+
+#include "./utils.h"
+
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#define INIT_SHARD_INBOX_LEN        (4 * 1024)
+#define DEFAULT_SHARD_INBOX_LIMIT   (16 * 1024 * 1024)
+#define SHARD_MSG_ALIGN             sizeof (uint64_t)
+
+/**
+ * @brief Enum class type of the control messages sent to a pipeline stage.
+ *
+ */
+typedef enum shard_msg_type_s {
+    SHARD_MSG_CLIENT        = 0,    /* Connected client handed off by another shard */
+    SHARD_MSG_WATCH_TOPIC   = 1,    /* A shard has subscribers of a topic */
+    SHARD_MSG_UNWATCH_TOPIC = 2,    /* A shard has no subscribers of a topic */
+    SHARD_MSG_STATS         = 3,    /* Print the stage counters */
+    SHARD_MSG_EXIT          = 4     /* Stop the stage */
+} shard_msg_type_t;
+
+/**
+ * @brief Header of a message in a shard inbox, followed by len
+ * data bytes and padded to SHARD_MSG_ALIGN bytes.
+ *
+ */
+typedef struct shard_msg_s {
+    uint32_t            size;               /* Message bytes, padding included */
+    uint16_t            len;                /* Data bytes */
+    uint8_t             type;               /* shard_msg_type_t value */
+    uint8_t             proto;              /* Wire format of a handed off client */
+    int32_t             fd;                 /* Socket of a handed off client */
+    uint32_t            shard;              /* Index of the posting shard */
+    struct sockaddr_in  addr;               /* Address of a handed off client */
+    char                data[];
+} shard_msg_t;
+
+/**
+ * @brief Struct class type of a multi producer, single consumer
+ * queue of control messages for a pipeline stage. The producers append the
+ * messages under a lock, the consumer takes all the posted messages
+ * at once by swapping two buffers. The eventfd is signalled when
+ * the first message is posted in an empty inbox.
+ *
+ */
+typedef struct shard_inbox_s {
+    pthread_mutex_t     lock;
+    int                 event_fd;           /* Readable while messages are posted */
+    uint8_t             *buf;               /* Posted messages */
+    size_t              len;
+    size_t              capacity;
+    uint8_t             *spare;             /* Messages taken by the consumer */
+    size_t              spare_capacity;
+    size_t              limit;              /* Max bytes of posted messages */
+    uint8_t             signal;             /* The inbox was empty when locked */
+    uint64_t            dropped;            /* Messages dropped on a full inbox */
+} shard_inbox_t;
+
+/**
+ * @brief Creates an empty shard inbox.
+ *
+ * @param inbox pointer to inbox structure to allocate, must be NULL.
+ * @param limit max bytes of the posted messages.
+ * @return err_t OK if the inbox was allocated or error otherwise.
+ */
+err_t create_shard_inbox(shard_inbox_t **inbox, size_t limit);
+
+/**
+ * @brief Frees a shard inbox and sets it to NULL, the
+ * posted messages are dropped.
+ *
+ * @param inbox pointer to inbox structure.
+ * @return err_t OK if the inbox was freed or error otherwise.
+ */
+err_t free_shard_inbox(shard_inbox_t **inbox);
+
+/**
+ * @brief Locks the inbox in order to append a group of messages.
+ *
+ * @param inbox inbox structure.
+ */
+void shard_inbox_lock(shard_inbox_t *inbox);
+
+/**
+ * @brief Appends a message to a locked inbox.
+ *
+ * @param inbox locked inbox structure.
+ * @param msg header of the message, the size and len fields are set.
+ * @param data data bytes of the message or NULL.
+ * @param len number of data bytes.
+ * @return err_t OK if the message was appended or SHARD_INBOX_FULL otherwise.
+ */
+err_t shard_inbox_append(shard_inbox_t *inbox, const shard_msg_t *msg, const void *data, size_t len);
+
+/**
+ * @brief Unlocks the inbox and wakes the consumer if the
+ * inbox got its first messages.
+ *
+ * @param inbox locked inbox structure.
+ */
+void shard_inbox_unlock(shard_inbox_t *inbox);
+
+/**
+ * @brief Posts one message, see shard_inbox_append.
+ *
+ * @param inbox inbox structure.
+ * @param msg header of the message, the size and len fields are set.
+ * @param data data bytes of the message or NULL.
+ * @param len number of data bytes.
+ * @return err_t OK if the message was posted or SHARD_INBOX_FULL otherwise.
+ */
+err_t shard_inbox_post(shard_inbox_t *inbox, const shard_msg_t *msg, const void *data, size_t len);
+
+/**
+ * @brief Takes all the posted messages, the messages stay
+ * valid until the next call. Just the consumer calls it.
+ *
+ * @param inbox inbox structure.
+ * @param buf pointer to variable to set the messages.
+ * @param len pointer to variable to set the bytes of the messages.
+ * @return err_t OK if the messages were taken or error otherwise.
+ */
+err_t shard_inbox_take(shard_inbox_t *inbox, uint8_t **buf, size_t *len);
+
+#endif /* SHARD_INBOX_H_ */
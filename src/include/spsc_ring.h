@@ -0,0 +1,199 @@
+/**
+ * @file spsc_ring.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include "./utils.h"
+
+#include <time.h>
+#include <sys/eventfd.h>
+
+#define DEFAULT_SPSC_RING_LEN   (8 * 1024 * 1024)
+#define SPSC_RING_ALIGN         sizeof (uint64_t)
+#define SPSC_RING_WRAP          UINT32_MAX          /* Length of the filler entry at the end of the ring */
+#define CACHE_LINE_LEN          64
+
+/**
+ * @brief Header of an entry in a ring, followed by len data
+ * bytes and padded to SPSC_RING_ALIGN bytes.
+ *
+ */
+typedef struct spsc_entry_s {
+    uint32_t    size;                       /* Entry bytes, padding included */
+    uint32_t    len;                        /* Data bytes or SPSC_RING_WRAP */
+    uint8_t     data[];
+} spsc_entry_t;
+
+/**
+ * @brief Struct class type of a bounded single producer, single consumer
+ * ring of variable size entries. The producer and the consumer never
+ * take a lock, every side publishes its position once per batch and
+ * caches the position of the other side. The eventfd wakes the consumer
+ * when the producer publishes entries in a ring it has drained.
+ *
+ * The positions grow forever, the offset in the buffer is the position
+ * modulo the capacity. An entry never wraps, the producer fills the end
+ * of the buffer with a filler entry instead.
+ *
+ */
+typedef struct spsc_ring_s {
+    /* Producer side */
+    size_t      head __attribute__((aligned(CACHE_LINE_LEN)));    /* Published entries end */
+    size_t      pending;                    /* Committed entries end, not published yet */
+    size_t      reserved;                   /* Start of the reserved entry */
+    size_t      tail_cache;                 /* Last seen consumer position */
+    uint64_t    full;                       /* Entries dropped on a full ring */
+
+    /* Consumer side */
+    size_t      tail __attribute__((aligned(CACHE_LINE_LEN)));    /* Released entries end */
+    size_t      next;                       /* Next entry to take */
+    size_t      head_cache;                 /* Last seen producer position */
+    uint64_t    entries;                    /* Entries taken */
+    uint64_t    batches;                    /* Batches taken, one load of the producer position each */
+    uint64_t    max_depth;                  /* Most bytes waiting in the ring */
+
+    /* Shared, not changed after creation */
+    uint8_t     *buf __attribute__((aligned(CACHE_LINE_LEN)));
+    size_t      capacity;                   /* Power of two */
+    int         event_fd;                   /* Readable while the consumer must wake */
+} spsc_ring_t;
+
+/**
+ * @brief Counters of a pipeline stage, the busy time is the time
+ * spent processing entries instead of waiting for them.
+ *
+ */
+typedef struct stage_stats_s {
+    uint64_t    started_ns;                 /* Monotonic start time of the stage */
+    uint64_t    busy_ns;                    /* Time spent processing */
+    uint64_t    mark_ns;                    /* Start of the current busy period */
+} stage_stats_t;
+
+/**
+ * @brief Creates an empty ring.
+ *
+ * @param ring pointer to ring structure to allocate, must be NULL.
+ * @param capacity ring bytes, rounded up to a power of two.
+ * @return err_t OK if the ring was allocated or error otherwise.
+ */
+err_t create_spsc_ring(spsc_ring_t **ring, size_t capacity);
+
+/**
+ * @brief Frees a ring and sets it to NULL, the entries are dropped.
+ *
+ * @param ring pointer to ring structure.
+ * @return err_t OK if the ring was freed or error otherwise.
+ */
+err_t free_spsc_ring(spsc_ring_t **ring);
+
+/**
+ * @brief Reserves an entry of at most max_len data bytes, the entry
+ * is added by spsc_ring_commit, the next reserve drops an entry that
+ * was not committed. Just the producer calls it.
+ *
+ * @param ring ring structure.
+ * @param max_len max data bytes of the entry.
+ * @param data pointer to variable to set the data of the entry.
+ * @return err_t OK if the entry was reserved or SPSC_RING_FULL otherwise.
+ */
+err_t spsc_ring_reserve(spsc_ring_t *ring, size_t max_len, uint8_t **data);
+
+/**
+ * @brief Adds the reserved entry with its actual length, the entry
+ * is seen by the consumer after spsc_ring_publish.
+ *
+ * @param ring ring structure.
+ * @param len data bytes of the entry, at most the reserved length.
+ */
+void spsc_ring_commit(spsc_ring_t *ring, size_t len);
+
+/**
+ * @brief Publishes the committed entries to the consumer and wakes
+ * it if it drained the ring. Just the producer calls it.
+ *
+ * @param ring ring structure.
+ */
+void spsc_ring_publish(spsc_ring_t *ring);
+
+/**
+ * @brief Clears the wakeup of the consumer, the consumer calls it
+ * before taking the entries.
+ *
+ * @param ring ring structure.
+ */
+void spsc_ring_ack(spsc_ring_t *ring);
+
+/**
+ * @brief Takes the next entry, the entry stays valid until the next call.
+ * The published entries are taken in batches, the space of a batch is
+ * released when the next batch is taken. When the ring is empty the
+ * consumer is woken by the next publish. Just the consumer calls it.
+ *
+ * @param ring ring structure.
+ * @param data pointer to variable to set the data of the entry.
+ * @param len pointer to variable to set the data bytes of the entry.
+ * @return err_t OK if an entry was taken or SPSC_RING_EMPTY otherwise.
+ */
+err_t spsc_ring_next(spsc_ring_t *ring, uint8_t **data, size_t *len);
+
+/**
+ * @brief Gets the bytes waiting in the ring, the value is
+ * approximate while the producer and the consumer run.
+ *
+ * @param ring ring structure.
+ * @return size_t bytes of the published entries not released yet.
+ */
+size_t spsc_ring_depth(spsc_ring_t *ring);
+
+/**
+ * @brief Gets the monotonic time in ns.
+ *
+ * @return uint64_t monotonic time.
+ */
+uint64_t stage_now_ns(void);
+
+/**
+ * @brief Marks the start of a busy period of a stage.
+ *
+ * @param stats stage counters.
+ */
+void stage_busy(stage_stats_t *stats);
+
+/**
+ * @brief Marks the end of a busy period of a stage.
+ *
+ * @param stats stage counters.
+ */
+void stage_idle(stage_stats_t *stats);
+
+/**
+ * @brief Gets the busy time of a stage since its start, in percents.
+ *
+ * @param stats stage counters.
+ * @return double busy percents.
+ */
+double stage_busy_percent(const stage_stats_t *stats);
+
+#endif /* SPSC_RING_H_ */
@@ -68,6 +68,7 @@ typedef struct client_s {
     char                    *cmd;           /* Buffer for reading stdin commands */
     tcp_msg_t               *send_msg;      /* Encapsulated TCP msg protocol for sending */
     tcp_msg_t               *recv_msg;      /* Encapsulated TCP msg protocol for receiving */
+    tcp_reader_t            reader;         /* Partial frames received from the server */
 } client_t;
 
 /**
@@ -27,17 +27,102 @@
 
 #include "./utils.h"
 
+#include <errno.h>
+
 #define MAX_TCP_MSG_BUF_LEN 2048
 
+#define TCP_PROTO_MAGIC     0xA5
+#define TCP_PROTO_VERSION   1
+#define TCP_FRAME_HDR_LEN   sizeof (uint16_t)
+
+#define INIT_TCP_WRITER_LEN 16
+#define TCP_WRITER_IOV_LEN  16
+
 /**
  * @brief Protocol data structure over the TCP Protocol.
  *
+ * On the wire a framed peer sends just the `len` header in
+ * network byte order followed by `len` data bytes, a legacy
+ * peer sends the whole structure.
+ *
  */
 typedef struct __attribute__((__packed__)) tcp_msg_s {
     uint16_t    len;
     char        data[MAX_TCP_MSG_BUF_LEN];
 } tcp_msg_t;
 
+/**
+ * @brief Enum class type to handle the
+ * wire format spoken by a peer.
+ *
+ */
+typedef enum tcp_proto_s {
+    TCP_PROTO_LEGACY    = 0,        /* Fixed sizeof (tcp_msg_t) frames */
+    TCP_PROTO_FRAMED    = 1         /* Length header followed by len bytes */
+} tcp_proto_t;
+
+/**
+ * @brief Handshake sent by a framed peer before its first frame.
+ * A legacy peer starts with the low byte of a small frame length,
+ * which can never be equal to TCP_PROTO_MAGIC.
+ *
+ */
+typedef struct __attribute__((__packed__)) tcp_hello_s {
+    uint8_t     magic;
+    uint8_t     version;
+} tcp_hello_t;
+
+/**
+ * @brief Incremental frame reassembly buffer for a
+ * non-blocking socket, complete frames are extracted
+ * one by one and the partial frame is kept for the next read.
+ *
+ */
+typedef struct tcp_reader_s {
+    tcp_proto_t proto;
+    uint8_t     *buf;
+    size_t      start;              /* First unprocessed byte */
+    size_t      end;                /* End of the received bytes */
+    size_t      capacity;
+} tcp_reader_t;
+
+/**
+ * @brief Immutable encoded frame shared by every outbound queue and
+ * store-and-forward backlog holding it. The message is serialized
+ * once, the frame is freed when the last reference is released.
+ *
+ */
+typedef struct tcp_frame_s {
+    uint32_t    refs;
+    uint16_t    len;                /* Number of data bytes */
+    uint64_t    seq;                /* Sequence number of the message */
+    uint8_t     *legacy;            /* Fixed size encoding, built on demand */
+    uint8_t     buf[];              /* Length header followed by len data bytes */
+} tcp_frame_t;
+
+/**
+ * @brief Bounded outbound queue of encoded frames for a
+ * non-blocking socket, the frames are sent in order and the
+ * first frame of the queue can be partially sent. An async
+ * queue never sends by itself, its oldest frames are gathered
+ * into one send that the caller submits and completes.
+ *
+ */
+typedef struct tcp_writer_s {
+    tcp_proto_t proto;
+    tcp_frame_t **frames;           /* Ring of queued frame references */
+    size_t      head;               /* Index of the oldest frame */
+    size_t      len;
+    size_t      capacity;
+    size_t      sent;               /* Bytes of the oldest frame already sent */
+    size_t      bytes;              /* Queued bytes that are not sent yet */
+    size_t      limit;              /* Max queued bytes */
+    uint8_t     async;              /* The frames are sent by submitted sends */
+    size_t      inflight;           /* Oldest frames gathered in the submitted send */
+    struct iovec *iovs;             /* Buffers of the submitted send */
+    struct msghdr hdr;
+} tcp_writer_t;
+
 /**
  * @brief Send an exact length message over a tcp socket.
  *
@@ -62,4 +147,180 @@ err_t send_tcp_msg(const int tcp_socket, void *buf, size_t buf_len);
  */
 err_t recv_tcp_msg(const int tcp_socket, void *buf, size_t buf_len);
 
+/**
+ * @brief Sends a protocol message as a single frame, a framed
+ * peer gets just the header and the `len` data bytes.
+ *
+ * @param tcp_socket socket fd to send the frame.
+ * @param msg message to send, `len` is in host byte order.
+ * @param proto wire format of the peer.
+ * @return err_t OK if the frame was sent or TCP_FAILED_SEND_RECV otherwise.
+ */
+err_t send_tcp_frame(const int tcp_socket, tcp_msg_t *msg, tcp_proto_t proto);
+
+/**
+ * @brief Receives exactly one frame on a blocking socket.
+ *
+ * @param tcp_socket socket fd to receive the frame.
+ * @param msg message to fill, `len` is set in host byte order.
+ * @param proto wire format of the peer.
+ * @return err_t OK if a frame was received or error otherwise.
+ */
+err_t recv_tcp_frame(const int tcp_socket, tcp_msg_t *msg, tcp_proto_t proto);
+
+/**
+ * @brief Sends the framed protocol handshake.
+ *
+ * @param tcp_socket socket fd to send the handshake.
+ * @return err_t OK if the handshake was sent or TCP_FAILED_SEND_RECV otherwise.
+ */
+err_t send_tcp_hello(const int tcp_socket);
+
+/**
+ * @brief Receives the first frame of a new connection and detects
+ * the wire format of the peer by its first byte.
+ *
+ * @param tcp_socket socket fd of the new connection.
+ * @param msg message to fill with the first frame.
+ * @param proto pointer to variable to set the wire format of the peer.
+ * @return err_t OK if the frame was received or error otherwise.
+ */
+err_t recv_tcp_handshake(const int tcp_socket, tcp_msg_t *msg, tcp_proto_t *proto);
+
+/**
+ * @brief Inits a frame reader for a peer.
+ *
+ * @param reader reader structure.
+ * @param proto wire format of the peer.
+ * @return err_t OK if the reader buffer was allocated or error otherwise.
+ */
+err_t init_tcp_reader(tcp_reader_t *reader, tcp_proto_t proto);
+
+/**
+ * @brief Frees the buffer of a frame reader.
+ *
+ * @param reader reader structure.
+ */
+void free_tcp_reader(tcp_reader_t *reader);
+
+/**
+ * @brief Reads the available bytes of a socket into the reader
+ * without blocking.
+ *
+ * @param tcp_socket socket fd to read from.
+ * @param reader reader structure.
+ * @return err_t OK if bytes were read, TCP_WOULD_BLOCK if no bytes
+ * are available or TCP_FAILED_SEND_RECV if the connection is closed.
+ */
+err_t tcp_reader_fill(const int tcp_socket, tcp_reader_t *reader);
+
+/**
+ * @brief Extracts the next complete frame from the reader.
+ *
+ * @param reader reader structure.
+ * @param msg message to fill, `len` is set in host byte order.
+ * @return err_t OK if a frame was extracted, TCP_FRAME_INCOMPLETE if
+ * more bytes are needed or TCP_INVALID_FRAME for a malformed header.
+ */
+err_t tcp_reader_next(tcp_reader_t *reader, tcp_msg_t *msg);
+
+/**
+ * @brief Inits an outbound queue for a peer.
+ *
+ * @param writer writer structure.
+ * @param proto wire format of the peer.
+ * @param limit max number of queued bytes.
+ * @return err_t OK if the queue was allocated or error otherwise.
+ */
+err_t init_tcp_writer(tcp_writer_t *writer, tcp_proto_t proto, size_t limit);
+
+/**
+ * @brief Frees the queued frames of an outbound queue.
+ *
+ * @param writer writer structure.
+ */
+void free_tcp_writer(tcp_writer_t *writer);
+
+/**
+ * @brief Serializes a protocol message into a shared frame
+ * holding one reference.
+ *
+ * @param frame pointer to frame to allocate, MUST be NULL.
+ * @param msg message to serialize, `len` is in host byte order.
+ * @return err_t OK if the frame was allocated or error otherwise.
+ */
+err_t create_tcp_frame(tcp_frame_t **frame, const tcp_msg_t *msg);
+
+/**
+ * @brief Takes one more reference of a shared frame.
+ *
+ * @param frame shared frame.
+ * @return tcp_frame_t* the same frame.
+ */
+tcp_frame_t* tcp_frame_acquire(tcp_frame_t *frame);
+
+/**
+ * @brief Releases one reference of a shared frame, the last
+ * reference frees the frame. The pointer is set to NULL.
+ *
+ * @param frame pointer to shared frame.
+ */
+void tcp_frame_release(tcp_frame_t **frame);
+
+/**
+ * @brief Sends a shared frame without blocking. If the queue is
+ * empty the frame is sent right away and the frame is queued just
+ * if the socket could not take all of it, otherwise the frame is
+ * queued behind the older frames in order to keep the stream ordered.
+ * A queued frame holds its own reference.
+ *
+ * @param tcp_socket non-blocking socket fd to send the frame.
+ * @param writer writer structure.
+ * @param frame shared frame to send.
+ * @return err_t OK if the frame was sent, TCP_WOULD_BLOCK if (a part of)
+ * the frame was queued, TCP_WRITER_FULL if the frame does not fit in the
+ * queue or TCP_FAILED_SEND_RECV if the connection is closed.
+ */
+err_t tcp_writer_send(const int tcp_socket, tcp_writer_t *writer, tcp_frame_t *frame);
+
+/**
+ * @brief Drops the oldest queued frame that was not partially sent.
+ *
+ * @param writer writer structure.
+ * @return err_t OK if a frame was dropped or TCP_WRITER_FULL
+ * if no frame can be dropped.
+ */
+err_t tcp_writer_drop_oldest(tcp_writer_t *writer);
+
+/**
+ * @brief Sends the queued frames until the queue is empty or
+ * the socket cannot take more bytes.
+ *
+ * @param tcp_socket non-blocking socket fd to send the frames.
+ * @param writer writer structure.
+ * @return err_t OK if the queue is empty, TCP_WOULD_BLOCK if frames are
+ * left in the queue or TCP_FAILED_SEND_RECV if the connection is closed.
+ */
+err_t tcp_writer_flush(const int tcp_socket, tcp_writer_t *writer);
+
+/**
+ * @brief Gathers the oldest frames of an async queue into one send,
+ * the frames are kept until the send is completed.
+ *
+ * @param writer writer structure.
+ * @param hdr pointer to variable to set the message to send.
+ * @return err_t OK if the send was prepared, TCP_WOULD_BLOCK if the queue
+ * is empty or a send is not completed yet or error otherwise.
+ */
+err_t tcp_writer_prepare(tcp_writer_t *writer, struct msghdr **hdr);
+
+/**
+ * @brief Completes the send of an async queue, the frames sent
+ * completely are released.
+ *
+ * @param writer writer structure.
+ * @param bytes number of sent bytes.
+ */
+void tcp_writer_complete(tcp_writer_t *writer, size_t bytes);
+
 #endif /* TCP_TYPE_H_ */
@@ -0,0 +1,130 @@
+/**
+ * @file topic_table.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TOPIC_TABLE_H_
+#define TOPIC_TABLE_H_
+
+#include "./utils.h"
+
+#define INIT_TOPIC_TABLE_LEN        64
+#define INIT_TOPIC_SUBS_LEN         4
+#define TOPIC_TABLE_MAX_LOAD        2           /* Buckets per topic, at least */
+
+/**
+ * @brief Struct class type of a compact
+ * subscriber entry from a topic list.
+ *
+ */
+typedef struct topic_sub_s {
+    uint32_t    client_idx;                 /* Index in the clients vector */
+    uint8_t     sf;                         /* Store and forward option */
+} topic_sub_t;
+
+/**
+ * @brief Struct class type of an interned topic
+ * with all its subscribers.
+ *
+ */
+typedef struct topic_entry_s {
+    char        *name;                      /* Interned topic name */
+    uint64_t    hash;
+    topic_sub_t *subs;                      /* Active and dead subscribers */
+    uint32_t    subs_len;
+    uint32_t    subs_capacity;
+} topic_entry_t;
+
+/**
+ * @brief Struct class type defining a topic index,
+ * topics are interned once and get a dense id, the
+ * name lookup is done with an open addressing hash table.
+ *
+ */
+typedef struct topic_table_s {
+    topic_entry_t   *entries;               /* Topics indexed by topic id */
+    uint32_t        len;
+    uint32_t        capacity;
+    uint32_t        *buckets;               /* Topic id + 1 or 0 for an empty bucket */
+    uint32_t        buckets_len;            /* Power of two */
+} topic_table_t;
+
+/**
+ * @brief Creates a topic table object.
+ *
+ * @param table pointer to table structure to allocate, must be NULL.
+ * @param init_topics initial number of topics to allocate.
+ * @return err_t OK if the table was allocated or error otherwise.
+ */
+err_t create_topic_table(topic_table_t **table, uint32_t init_topics);
+
+/**
+ * @brief Frees a topic table object and sets it to NULL.
+ *
+ * @param table pointer to table structure.
+ * @return err_t OK if the table was freed or error otherwise.
+ */
+err_t free_topic_table(topic_table_t **table);
+
+/**
+ * @brief Finds the id of an interned topic.
+ *
+ * @param table table structure.
+ * @param name topic name.
+ * @param topic_id pointer to variable to set the topic id.
+ * @return err_t OK if the topic was found or TOPIC_TABLE_TOPIC_NOT_FOUND otherwise.
+ */
+err_t topic_table_find(topic_table_t *table, const char *name, uint32_t *topic_id);
+
+/**
+ * @brief Interns a topic name, a new topic gets the next dense id.
+ *
+ * @param table table structure.
+ * @param name topic name.
+ * @param topic_id pointer to variable to set the topic id.
+ * @return err_t OK if the topic was found or added or error otherwise.
+ */
+err_t topic_table_intern(topic_table_t *table, const char *name, uint32_t *topic_id);
+
+/**
+ * @brief Adds a subscriber to a topic, if the client is already
+ * subscribed just its store and forward option is updated.
+ *
+ * @param table table structure.
+ * @param topic_id valid topic id.
+ * @param client_idx index of the client in the clients vector.
+ * @param sf store and forward option.
+ * @return err_t OK if the subscriber was added or error otherwise.
+ */
+err_t topic_table_add_sub(topic_table_t *table, uint32_t topic_id, uint32_t client_idx, uint8_t sf);
+
+/**
+ * @brief Removes a subscriber from a topic.
+ *
+ * @param table table structure.
+ * @param topic_id valid topic id.
+ * @param client_idx index of the client in the clients vector.
+ * @return err_t OK if the subscriber was removed or error otherwise.
+ */
+err_t topic_table_remove_sub(topic_table_t *table, uint32_t topic_id, uint32_t client_idx);
+
+#endif /* TOPIC_TABLE_H_ */
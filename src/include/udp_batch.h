@@ -0,0 +1,107 @@
+/**
+ * @file udp_batch.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef UDP_BATCH_H_
+#define UDP_BATCH_H_
+
+#include "./utils.h"
+#include "./udp_type.h"
+
+#include <errno.h>
+
+/* A datagram slot holds the largest message of the UDP clients */
+#define UDP_SLOT_LEN            (MAX_TOPIC_LEN + MAX_STRING_LEN + 8)
+
+#define DEFAULT_UDP_BATCH_LEN   32
+#define DEFAULT_UDP_DRAIN_LIMIT 256
+
+/**
+ * @brief Struct class type containing the
+ * counters of the batched UDP ingestion.
+ *
+ */
+typedef struct udp_batch_stats_s {
+    uint64_t    batches;                /* recvmmsg calls that returned datagrams */
+    uint64_t    datagrams;              /* Received datagrams */
+    uint64_t    last_batch;             /* Datagrams of the last batch */
+    uint64_t    max_batch;              /* Largest batch */
+    uint64_t    full_batches;           /* Batches that filled all the slots */
+    uint64_t    drain_limit_hits;       /* Wakeups stopped by the drain limit */
+    uint64_t    parse_errors;           /* Dropped malformed datagrams */
+} udp_batch_stats_t;
+
+/**
+ * @brief Struct class type of a ring of preallocated
+ * datagram slots filled by a single recvmmsg call.
+ *
+ */
+typedef struct udp_batch_s {
+    size_t              len;            /* Number of slots */
+    char                *bufs;          /* len * UDP_SLOT_LEN bytes */
+    struct iovec        *iovs;
+    struct mmsghdr      *msgs;
+    struct sockaddr_in  *addrs;         /* Source address of every slot */
+    udp_batch_stats_t   stats;
+} udp_batch_t;
+
+/**
+ * @brief Creates a batch of datagram slots.
+ *
+ * @param batch pointer to batch structure to allocate, must be NULL.
+ * @param len number of datagram slots.
+ * @return err_t OK if the batch was allocated or error otherwise.
+ */
+err_t create_udp_batch(udp_batch_t **batch, size_t len);
+
+/**
+ * @brief Frees a batch of datagram slots and sets it to NULL.
+ *
+ * @param batch pointer to batch structure.
+ * @return err_t OK if the batch was freed or error otherwise.
+ */
+err_t free_udp_batch(udp_batch_t **batch);
+
+/**
+ * @brief Receives up to max_msgs datagrams with a single recvmmsg
+ * call without blocking. The bytes after every datagram are cleared
+ * up to the end of its slot, so the parsers never read stale data.
+ *
+ * @param batch batch structure.
+ * @param udp_socket UDP socket to read from.
+ * @param max_msgs maximum number of datagrams to receive.
+ * @param nmsgs pointer to variable to set the number of received datagrams.
+ * @return err_t OK if the call succeeded (nmsgs can be 0) or error otherwise.
+ */
+err_t udp_batch_recv(udp_batch_t *batch, int udp_socket, size_t max_msgs, size_t *nmsgs);
+
+/**
+ * @brief Gets the buffer of a datagram slot.
+ *
+ * @param batch batch structure.
+ * @param slot valid slot index.
+ * @return char* start of the slot buffer.
+ */
+char *udp_batch_buf(udp_batch_t *batch, size_t slot);
+
+#endif /* UDP_BATCH_H_ */
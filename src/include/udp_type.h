@@ -27,9 +27,21 @@
 
 #include "./utils.h"
 
+#include <stddef.h>
+
 #define MAX_TOPIC_LEN 51
 #define MAX_STRING_LEN 1501
 
+/* Wire sizes of the numeric payloads */
+#define UDP_INT_LEN         (sizeof (uint8_t) + sizeof (uint32_t))
+#define UDP_SHORT_REAL_LEN  sizeof (uint16_t)
+#define UDP_FLOAT_LEN       (sizeof (uint8_t) + sizeof (uint32_t) + sizeof (uint8_t))
+
+#define UDP_RECORD_ALIGN    sizeof (uint64_t)
+#define UDP_RECORD_MAX_LEN  udp_record_align(offsetof (udp_record_t, payload) + MAX_STRING_LEN)
+
+#define udp_record_align(len) (((len) + UDP_RECORD_ALIGN - 1) & ~(UDP_RECORD_ALIGN - 1))
+
 /**
  * @brief Enum class type to handle
  * the udp message types.
@@ -43,47 +55,78 @@ typedef enum udp_data_type_s {
 } udp_data_type_t;
 
 /**
- * @brief Union class type to store
- * a udp message data depending on the
- * udp message type.
+ * @brief Compact record of a udp message, a small header followed
+ * by the payload sized to the actual value. The numeric payloads keep
+ * their wire bytes and are decoded when the message is rendered, a
+ * STRING payload keeps just its characters. The payload is always
+ * followed by a '\0' byte.
  *
  */
-typedef union udp_data_s {
-    int32_t     INT;
-    double      SHORT_REAL;
-    double      FLOAT;
-    char        STRING[MAX_STRING_LEN];
-} udp_data_t;
+typedef struct udp_record_s {
+    uint64_t    stamp;                      /* Monotonic arrival time in ms */
+    uint32_t    topic_id;                   /* Id of the topic in the topic index */
+    uint32_t    ip;                         /* Source address, network order */
+    uint16_t    port;                       /* Source port, network order */
+    uint16_t    len;                        /* Payload bytes */
+    uint8_t     type;                       /* udp_data_type_t value */
+    char        payload[];
+} udp_record_t;
 
 /**
- * @brief Struct class type containing
- * udp message metadata and exact data.
+ * @brief Parses a buffer into a udp message record. The record is
+ * written in place, the caller must provide UDP_RECORD_MAX_LEN bytes.
+ * The topic id is not set, the topic name is copied in `topic` in
+ * order to be interned by the caller.
  *
+ * @param record pointer to memory location to parse the message.
+ * @param addr pointer to memory location of the udp address information.
+ * @param buf pointer to buffer containing the message bytes.
+ * @param topic buffer of MAX_TOPIC_LEN bytes to set the topic name.
+ * @return err_t OK if parser executed successfully or UDP_* errors otherwise.
  */
-typedef struct udp_type_s {
-    struct sockaddr_in  addr;
-    char                topic[MAX_TOPIC_LEN];
-    udp_data_type_t     type;
-    udp_data_t          data;
-} udp_type_t;
+err_t parse_udp_type_from(udp_record_t *record, struct sockaddr_in *addr, char *buf, char *topic);
 
 /**
- * @brief Parses a buffer into a udp message type.
+ * @brief Gets the number of bytes of a record, including the padding
+ * that keeps the next record aligned.
  *
- * @param udp_type_var pointer to memory location to parse the message.
- * @param addr pointer to memory location of the udp address information.
- * @param buf pointer to buffer containing the message bytes.
- * @return err_t OK if parser executed successfully or UDP_* errors otherwise.
+ * @param record pointer to udp message record.
+ * @return size_t record bytes.
+ */
+size_t udp_record_size(const udp_record_t *record);
+
+/**
+ * @brief Decodes the value of an INT record.
+ *
+ * @param record pointer to udp message record.
+ * @return int32_t value of the message.
+ */
+int32_t udp_record_int(const udp_record_t *record);
+
+/**
+ * @brief Decodes the value of a SHORT_REAL record.
+ *
+ * @param record pointer to udp message record.
+ * @return double value of the message.
+ */
+double udp_record_short_real(const udp_record_t *record);
+
+/**
+ * @brief Decodes the value of a FLOAT record.
+ *
+ * @param record pointer to udp message record.
+ * @return double value of the message.
  */
-err_t parse_udp_type_from(udp_type_t *udp_type_var, struct sockaddr_in *addr, char *buf);
+double udp_record_float(const udp_record_t *record);
 
 /**
- * @brief Prints a parsed udp message type on stderr
+ * @brief Prints a parsed udp message record on stderr
  * for debugging purposes.
  *
- * @param udp_type_var pointer to udp message type.
+ * @param record pointer to udp message record.
+ * @param topic topic name of the message.
  * @return err_t OK if printing went successfully.
  */
-err_t print_udp_type(udp_type_t *udp_type_var);
+err_t print_udp_type(udp_record_t *record, const char *topic);
 
 #endif /* UDP_TYPE_H_ */
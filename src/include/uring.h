@@ -0,0 +1,181 @@
+/**
+ * @file uring.h
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef URING_H_
+#define URING_H_
+
+#include "./utils.h"
+
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define URING_SQ_LEN            256
+#define URING_CQ_LEN            4096
+#define URING_BUF_GROUP         0
+
+/**
+ * @brief Counters of an io_uring instance.
+ *
+ */
+typedef struct uring_stats_s {
+    uint64_t    enters;                 /* io_uring_enter calls */
+    uint64_t    sqes;                   /* Submitted operations */
+    uint64_t    cqes;                   /* Reaped completions */
+    uint64_t    bufs_exhausted;         /* Receives stopped without a provided buffer */
+} uring_stats_t;
+
+/**
+ * @brief Struct class type of an io_uring instance driven with the
+ * raw system calls. The operations are queued in the submission ring
+ * and submitted together by the next wait call, the completions are
+ * reaped one by one. The provided buffers of the instance are selected
+ * by the kernel for the receives of the URING_BUF_GROUP group.
+ *
+ */
+typedef struct uring_s {
+    int                     ring_fd;
+    uint8_t                 *ring_mem;          /* Submission and completion rings */
+    size_t                  ring_mem_len;
+    struct io_uring_sqe     *sqes;
+    size_t                  sqes_len;
+
+    /* Submission ring shared with the kernel */
+    uint32_t                *sq_head;
+    uint32_t                *sq_tail;
+    uint32_t                *sq_array;
+    uint32_t                sq_mask;
+    uint32_t                sq_entries;
+    uint32_t                sqe_tail;           /* Queued operations end, not submitted yet */
+
+    /* Completion ring shared with the kernel */
+    uint32_t                *cq_head;
+    uint32_t                *cq_tail;
+    struct io_uring_cqe     *cqes;
+    uint32_t                cq_mask;
+
+    /* Provided buffers */
+    struct io_uring_buf_ring *buf_ring;         /* Page aligned ring of free buffers */
+    uint8_t                 *bufs;
+    size_t                  buf_len;
+    uint16_t                nbufs;              /* Power of two */
+    uint16_t                buf_tail;
+
+    uring_stats_t           stats;
+} uring_t;
+
+/**
+ * @brief Creates an io_uring instance.
+ *
+ * @param ring pointer to ring structure to allocate, must be NULL.
+ * @return err_t OK if the instance was created or error otherwise,
+ * URING_FAILED_SETUP if the kernel does not support the used features.
+ */
+err_t create_uring(uring_t **ring);
+
+/**
+ * @brief Frees an io_uring instance and sets it to NULL, the
+ * pending operations are cancelled by the kernel.
+ *
+ * @param ring pointer to ring structure.
+ * @return err_t OK if the instance was freed or error otherwise.
+ */
+err_t free_uring(uring_t **ring);
+
+/**
+ * @brief Gets a cleared submission entry, the queued entries are
+ * submitted first if the submission ring is full.
+ *
+ * @param ring ring structure.
+ * @param sqe pointer to variable to set the submission entry.
+ * @return err_t OK if an entry was found or URING_FAILED_SUBMIT otherwise.
+ */
+err_t uring_get_sqe(uring_t *ring, struct io_uring_sqe **sqe);
+
+/**
+ * @brief Submits the queued operations without waiting.
+ *
+ * @param ring ring structure.
+ * @return err_t OK if the operations were submitted or URING_FAILED_SUBMIT otherwise.
+ */
+err_t uring_submit(uring_t *ring);
+
+/**
+ * @brief Submits the queued operations and waits for a completion,
+ * the wait is skipped if completions are left from the last reap.
+ *
+ * @param ring ring structure.
+ * @param timeout timeout in milliseconds or -1 to block.
+ * @return err_t OK if the wait returned (the completion ring can
+ * be empty on timeout) or URING_FAILED_SUBMIT otherwise.
+ */
+err_t uring_wait(uring_t *ring, int timeout);
+
+/**
+ * @brief Gets the oldest completion without removing it.
+ *
+ * @param ring ring structure.
+ * @return struct io_uring_cqe* oldest completion or NULL if there is none.
+ */
+struct io_uring_cqe *uring_peek_cqe(uring_t *ring);
+
+/**
+ * @brief Removes the oldest completion.
+ *
+ * @param ring ring structure.
+ */
+void uring_cqe_seen(uring_t *ring);
+
+/**
+ * @brief Registers the provided buffers of the instance, it can
+ * be called once.
+ *
+ * @param ring ring structure.
+ * @param nbufs number of buffers, a power of two.
+ * @param buf_len bytes of every buffer.
+ * @return err_t OK if the buffers were registered or error otherwise.
+ */
+err_t uring_add_bufs(uring_t *ring, uint16_t nbufs, size_t buf_len);
+
+/**
+ * @brief Gets a provided buffer selected by the kernel.
+ *
+ * @param ring ring structure.
+ * @param bid buffer id from the completion flags.
+ * @return uint8_t* start of the buffer.
+ */
+uint8_t *uring_buf(uring_t *ring, uint16_t bid);
+
+/**
+ * @brief Gives a provided buffer back to the kernel.
+ *
+ * @param ring ring structure.
+ * @param bid buffer id from the completion flags.
+ */
+void uring_release_buf(uring_t *ring, uint16_t bid);
+
+#endif /* URING_H_ */
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <inttypes.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -134,7 +135,64 @@ typedef enum err_s {
     CLIENTS_VEC_COUND_NOT_FIND_TOPIC            = -45,
     CLIENTS_VEC_INDEX_OUT_OF_BOUND              = -46,
 
-    INPUT_WRONG_FORMAT                          = -47
+    INPUT_WRONG_FORMAT                          = -47,
+
+    POLL_VEC_FAILED_EPOLL                       = -48,
+    POLL_VEC_FD_NOT_FOUND                       = -49,
+    SERVER_INVALID_CONFIG                       = -50,
+
+    TCP_WOULD_BLOCK                             = -51,
+    TCP_FRAME_INCOMPLETE                        = -52,
+    TCP_INVALID_FRAME                           = -53,
+    TCP_UNSUPPORTED_VERSION                     = -54,
+    TCP_FAILED_ALLOCATION                       = -55,
+
+    TOPIC_TABLE_INPUT_IS_NOT_NULL               = -56,
+    TOPIC_TABLE_INPUT_IS_NULL                   = -57,
+    TOPIC_TABLE_FAILED_ALLOCATION               = -58,
+    TOPIC_TABLE_TOPIC_NOT_FOUND                 = -59,
+    TOPIC_TABLE_SUB_NOT_FOUND                   = -60,
+
+    UDP_BATCH_INPUT_IS_NOT_NULL                 = -61,
+    UDP_BATCH_INPUT_IS_NULL                     = -62,
+    UDP_BATCH_FAILED_ALLOCATION                 = -63,
+    UDP_BATCH_FAILED_RECV                       = -64,
+
+    TCP_WRITER_FULL                             = -65,
+
+    MSG_STORE_INPUT_IS_NOT_NULL                 = -66,
+    MSG_STORE_INPUT_IS_NULL                     = -67,
+    MSG_STORE_FAILED_ALLOCATION                 = -68,
+    MSG_STORE_SEQ_NOT_FOUND                     = -69,
+
+    JOURNAL_INPUT_IS_NOT_NULL                   = -70,
+    JOURNAL_INPUT_IS_NULL                       = -71,
+    JOURNAL_FAILED_ALLOCATION                   = -72,
+    JOURNAL_FAILED_IO                           = -73,
+    JOURNAL_INVALID_FILE                        = -74,
+    SERVER_FAILED_JOURNAL                       = -75,
+
+    SHARD_INBOX_INPUT_IS_NOT_NULL               = -76,
+    SHARD_INBOX_INPUT_IS_NULL                   = -77,
+    SHARD_INBOX_FAILED_ALLOCATION               = -78,
+    SHARD_INBOX_FULL                            = -79,
+    SERVER_POOL_INPUT_IS_NULL                   = -80,
+    SERVER_POOL_FAILED_ALLOCATION               = -81,
+    SERVER_POOL_FAILED_THREAD                   = -82,
+    SERVER_FAILED_SHARD_INBOX                   = -83,
+
+    SPSC_RING_INPUT_IS_NOT_NULL                 = -84,
+    SPSC_RING_INPUT_IS_NULL                     = -85,
+    SPSC_RING_FAILED_ALLOCATION                 = -86,
+    SPSC_RING_FULL                              = -87,
+    SPSC_RING_EMPTY                             = -88,
+
+    URING_INPUT_IS_NOT_NULL                     = -89,
+    URING_INPUT_IS_NULL                         = -90,
+    URING_FAILED_ALLOCATION                     = -91,
+    URING_FAILED_SETUP                          = -92,
+    URING_FAILED_SUBMIT                         = -93,
+    POLL_VEC_FAILED_URING                       = -94
 } err_t;
 
 /**
@@ -165,4 +223,13 @@ void debug_msg_and_exit(const err_t error);
  */
 uint32_t ipow(uint32_t base, uint8_t exp);
 
+/**
+ * @brief Hashes a null terminated string with
+ * the 64 bits FNV-1a function.
+ *
+ * @param str string to hash.
+ * @return uint64_t hash of the string.
+ */
+uint64_t hash_str(const char *str);
+
 #endif /* UTILS_H_ */
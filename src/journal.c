@@ -0,0 +1,834 @@
+/**
+ * @file journal.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/journal.h"
+
+/**
+ * @brief Struct class type of a restored backlog message,
+ * used to merge the backlogs of all clients by message order.
+ *
+ */
+typedef struct journal_entry_s {
+    uint64_t    seq;
+    uint32_t    client_idx;
+    tcp_frame_t *frame;
+} journal_entry_t;
+
+/**
+ * @brief Gets the monotonic time in milliseconds.
+ *
+ * @return uint64_t current time in ms.
+ */
+static uint64_t journal_now_ms(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Computes the 32 bits FNV-1a checksum of a record.
+ *
+ * @param rec record with its length, type and data set.
+ * @return uint32_t checksum of the record.
+ */
+static uint32_t journal_sum(const journal_rec_t *rec) {
+    uint32_t sum = 2166136261U;
+    const uint8_t *bytes = (const uint8_t *)&rec->len;
+
+    for (size_t iter = 0; iter < sizeof rec->len; ++iter) {
+        sum = (sum ^ bytes[iter]) * 16777619U;
+    }
+
+    sum = (sum ^ rec->type) * 16777619U;
+
+    for (uint32_t iter = 0; iter < rec->len; ++iter) {
+        sum = (sum ^ rec->data[iter]) * 16777619U;
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Gets the number of bytes of a record, including the padding.
+ *
+ * @param len data bytes of the record.
+ * @return size_t record bytes.
+ */
+static size_t journal_rec_size(size_t len) {
+    return (sizeof (journal_rec_t) + len + JOURNAL_REC_ALIGN - 1) & ~(JOURNAL_REC_ALIGN - 1);
+}
+
+/**
+ * @brief Resizes the journal file and its mapping.
+ *
+ * @param journal journal structure.
+ * @param map_len new length of the file.
+ * @return err_t OK if the file was mapped or JOURNAL_FAILED_IO otherwise.
+ */
+static err_t journal_map(journal_t *journal, size_t map_len) {
+    if (ftruncate(journal->fd, (off_t)map_len) < 0) {
+        return JOURNAL_FAILED_IO;
+    }
+
+    void *map = journal->map == NULL
+        ? mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, journal->fd, 0)
+        : mremap(journal->map, journal->map_len, map_len, MREMAP_MAYMOVE);
+
+    if (map == MAP_FAILED) {
+        return JOURNAL_FAILED_IO;
+    }
+
+    journal->map = map;
+    journal->map_len = map_len;
+
+    return OK;
+}
+
+/**
+ * @brief Unmaps and closes a journal file and frees the journal.
+ *
+ * @param journal journal structure.
+ */
+static void journal_release(journal_t *journal) {
+    if (journal->map != NULL) {
+        munmap(journal->map, journal->map_len);
+    }
+
+    if (journal->fd >= 0) {
+        close(journal->fd);
+    }
+
+    free(journal->recipients);
+    free(journal);
+}
+
+/**
+ * @brief Opens and maps a journal file, a missing or empty
+ * file gets a new header.
+ *
+ * @param journal pointer to journal structure to allocate.
+ * @param path path of the journal file.
+ * @param truncate 1 to drop the previous content of the file.
+ * @param sync_ms max delay in ms of a record flush.
+ * @return err_t OK if the file was mapped or error otherwise.
+ */
+static err_t journal_open_file(journal_t **journal, const char *path, uint8_t truncate, uint64_t sync_ms) {
+    *journal = calloc(1, sizeof **journal);
+    if (*journal == NULL) {
+        return JOURNAL_FAILED_ALLOCATION;
+    }
+
+    (*journal)->sync_ms = sync_ms;
+    (*journal)->recipients_capacity = JOURNAL_INIT_RECIPIENTS;
+    (*journal)->recipients = malloc(sizeof *(*journal)->recipients * (*journal)->recipients_capacity);
+    (*journal)->fd = open(path, O_RDWR | O_CREAT | (truncate == 1 ? O_TRUNC : 0), 0644);
+
+    if (((*journal)->recipients == NULL) || ((*journal)->fd < 0)) {
+        err_t err = (*journal)->fd < 0 ? JOURNAL_FAILED_IO : JOURNAL_FAILED_ALLOCATION;
+
+        journal_release(*journal);
+        *journal = NULL;
+
+        return err;
+    }
+
+    struct stat info;
+    if (fstat((*journal)->fd, &info) < 0) {
+        journal_release(*journal);
+        *journal = NULL;
+
+        return JOURNAL_FAILED_IO;
+    }
+
+    size_t file_len = (size_t)info.st_size;
+    uint8_t is_new = (uint8_t)(file_len == 0);
+
+    if ((is_new == 0) && (file_len < sizeof (journal_header_t))) {
+        journal_release(*journal);
+        *journal = NULL;
+
+        return JOURNAL_INVALID_FILE;
+    }
+
+    if (journal_map(*journal, is_new == 1 ? JOURNAL_GROW_BYTES : file_len) != OK) {
+        journal_release(*journal);
+        *journal = NULL;
+
+        return JOURNAL_FAILED_IO;
+    }
+
+    journal_header_t *header = (journal_header_t *)(*journal)->map;
+
+    if (is_new == 1) {
+        header->magic = JOURNAL_MAGIC;
+        header->version = JOURNAL_VERSION;
+    } else if ((header->magic != JOURNAL_MAGIC) || (header->version != JOURNAL_VERSION)) {
+        journal_release(*journal);
+        *journal = NULL;
+
+        return JOURNAL_INVALID_FILE;
+    }
+
+    (*journal)->used = sizeof (journal_header_t);
+    (*journal)->synced = is_new == 1 ? 0 : (*journal)->used;
+
+    return OK;
+}
+
+/**
+ * @brief Gets room for a record at the end of the journal,
+ * the file grows if the record does not fit.
+ *
+ * @param journal journal structure.
+ * @param type type of the record.
+ * @param len data bytes of the record.
+ * @return journal_rec_t* record to fill or NULL if the file could not grow.
+ */
+static journal_rec_t* journal_reserve(journal_t *journal, journal_rec_type_t type, size_t len) {
+    size_t size = journal_rec_size(len);
+
+    if (journal->used + size > journal->map_len) {
+        size_t map_len = journal->map_len + (size > JOURNAL_GROW_BYTES ? size : JOURNAL_GROW_BYTES);
+
+        if (journal_map(journal, map_len) != OK) {
+            return NULL;
+        }
+    }
+
+    journal_rec_t *rec = (journal_rec_t *)(journal->map + journal->used);
+
+    rec->len = (uint32_t)len;
+    rec->type = (uint8_t)type;
+
+    return rec;
+}
+
+/**
+ * @brief Seals a filled record with its checksum and appends it.
+ *
+ * @param journal journal structure.
+ * @param rec record got by journal_reserve.
+ */
+static void journal_commit(journal_t *journal, journal_rec_t *rec) {
+    size_t size = journal_rec_size(rec->len);
+
+    rec->sum = journal_sum(rec);
+
+    journal->used += size;
+    journal->stats.records++;
+    journal->stats.bytes += size;
+}
+
+/**
+ * @brief Appends a record with an optional client index followed
+ * by an optional byte and a string.
+ *
+ * @param journal journal structure.
+ * @param type type of the record.
+ * @param client_idx index of the client, used if has_idx is 1.
+ * @param has_idx 1 if the record starts with the client index.
+ * @param opt optional byte, used if has_opt is 1.
+ * @param has_opt 1 if the record has the optional byte.
+ * @param str string of the record, stored with its '\0'.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+static err_t journal_append_str(journal_t *journal, journal_rec_type_t type, size_t client_idx,
+    uint8_t has_idx, uint8_t opt, uint8_t has_opt, const char *str) {
+    if ((journal == NULL) || (str == NULL)) {
+        return JOURNAL_INPUT_IS_NULL;
+    }
+
+    uint32_t idx = (uint32_t)client_idx;
+    size_t str_len = strlen(str) + 1;
+    size_t pos = 0;
+
+    journal_rec_t *rec = journal_reserve(
+        journal,
+        type,
+        (has_idx == 1 ? sizeof idx : 0) + has_opt + str_len
+    );
+
+    if (rec == NULL) {
+        return JOURNAL_FAILED_IO;
+    }
+
+    if (has_idx == 1) {
+        memcpy(rec->data, &idx, sizeof idx);
+        pos += sizeof idx;
+    }
+
+    if (has_opt == 1) {
+        rec->data[pos++] = opt;
+    }
+
+    memcpy(rec->data + pos, str, str_len);
+
+    journal_commit(journal, rec);
+
+    return OK;
+}
+
+/**
+ * @brief Appends a new client, the clients are restored in the
+ * order of their records so the client indexes stay the same.
+ *
+ * @param journal journal structure.
+ * @param client_id id of the new client.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_client(journal_t *journal, const char *client_id) {
+    return journal_append_str(journal, JOURNAL_CLIENT, 0, 0, 0, 0, client_id);
+}
+
+/**
+ * @brief Appends a subscription of a client.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @param topic topic name.
+ * @param sf store and forward option.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_subscribe(journal_t *journal, size_t client_idx, const char *topic, client_options_t sf) {
+    return journal_append_str(journal, JOURNAL_SUBSCRIBE, client_idx, 1, (uint8_t)sf, 1, topic);
+}
+
+/**
+ * @brief Appends an unsubscription of a client.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @param topic topic name.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_unsubscribe(journal_t *journal, size_t client_idx, const char *topic) {
+    return journal_append_str(journal, JOURNAL_UNSUBSCRIBE, client_idx, 1, 0, 0, topic);
+}
+
+/**
+ * @brief Adds a client whose backlog got the next frame.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @return err_t OK if the client was added or error otherwise.
+ */
+err_t journal_add_recipient(journal_t *journal, size_t client_idx) {
+    if (journal == NULL) {
+        return JOURNAL_INPUT_IS_NULL;
+    }
+
+    if (journal->recipients_len == journal->recipients_capacity) {
+        uint32_t *recipients_real = realloc(
+            journal->recipients,
+            sizeof *journal->recipients * journal->recipients_capacity * REALLOC_FACTOR
+        );
+
+        if (recipients_real == NULL) {
+            return JOURNAL_FAILED_ALLOCATION;
+        }
+
+        journal->recipients = recipients_real;
+        journal->recipients_capacity *= REALLOC_FACTOR;
+    }
+
+    journal->recipients[journal->recipients_len] = (uint32_t)client_idx;
+    (journal->recipients_len)++;
+
+    return OK;
+}
+
+/**
+ * @brief Appends a frame stacked in the backlogs of the added
+ * recipients, nothing is appended if there are no recipients.
+ *
+ * @param journal journal structure.
+ * @param frame shared frame of the message.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_frame(journal_t *journal, tcp_frame_t *frame) {
+    if ((journal == NULL) || (frame == NULL)) {
+        return JOURNAL_INPUT_IS_NULL;
+    }
+
+    if (journal->recipients_len == 0) {
+        return OK;
+    }
+
+    uint32_t recipients_len = (uint32_t)journal->recipients_len;
+    size_t idxs_len = sizeof *journal->recipients * recipients_len;
+
+    /* The recipients are consumed even if the record is lost */
+    journal->recipients_len = 0;
+
+    journal_rec_t *rec = journal_reserve(
+        journal,
+        JOURNAL_FRAME,
+        sizeof recipients_len + idxs_len + frame->len
+    );
+
+    if (rec == NULL) {
+        return JOURNAL_FAILED_IO;
+    }
+
+    memcpy(rec->data, &recipients_len, sizeof recipients_len);
+    memcpy(rec->data + sizeof recipients_len, journal->recipients, idxs_len);
+    memcpy(
+        rec->data + sizeof recipients_len + idxs_len,
+        frame->buf + TCP_FRAME_HDR_LEN,
+        frame->len
+    );
+
+    journal_commit(journal, rec);
+
+    return OK;
+}
+
+/**
+ * @brief Appends the number of messages taken from the
+ * front of a client backlog.
+ *
+ * @param journal journal structure.
+ * @param client_idx index of the client.
+ * @param msgs number of messages.
+ * @return err_t OK if the record was appended or error otherwise.
+ */
+err_t journal_consume(journal_t *journal, size_t client_idx, size_t msgs) {
+    if (journal == NULL) {
+        return JOURNAL_INPUT_IS_NULL;
+    }
+
+    uint32_t values[2] = { (uint32_t)client_idx, (uint32_t)msgs };
+
+    journal_rec_t *rec = journal_reserve(journal, JOURNAL_CONSUME, sizeof values);
+    if (rec == NULL) {
+        return JOURNAL_FAILED_IO;
+    }
+
+    memcpy(rec->data, values, sizeof values);
+
+    journal_commit(journal, rec);
+
+    return OK;
+}
+
+/**
+ * @brief Checks that a record data holds a '\0' terminated
+ * string starting at a position.
+ *
+ * @param rec journal record.
+ * @param pos position of the string.
+ * @return uint8_t 1 if the string is valid or 0 otherwise.
+ */
+static uint8_t journal_rec_has_str(const journal_rec_t *rec, size_t pos) {
+    return (uint8_t)((pos < rec->len) && (memchr(rec->data + pos, '\0', rec->len - pos) != NULL));
+}
+
+/**
+ * @brief Applies one valid record to the clients vector, the
+ * records referring unknown clients are skipped.
+ *
+ * @param journal journal structure.
+ * @param rec journal record.
+ * @param clients clients vector to restore.
+ * @param msg message buffer for the restored frames.
+ * @return err_t OK if the record was applied or skipped, error otherwise.
+ */
+static err_t journal_apply(journal_t *journal, const journal_rec_t *rec, client_vec_t *clients, tcp_msg_t *msg) {
+    uint32_t values[2] = { 0, 0 };
+    size_t client_idx = 0;
+
+    if ((rec->type != JOURNAL_CLIENT) && (rec->len >= sizeof values[0])) {
+        memcpy(&values[0], rec->data, sizeof values[0]);
+    }
+
+    switch (rec->type) {
+        case JOURNAL_CLIENT:
+            if ((journal_rec_has_str(rec, 0) == 0) || (strlen((const char *)rec->data) >= MAX_ID_CLIENT_LEN)) {
+                return OK;
+            }
+
+            return restore_client(clients, (const char *)rec->data, &client_idx);
+        case JOURNAL_SUBSCRIBE:
+            if (journal_rec_has_str(rec, sizeof values[0] + 1) == 0) {
+                return OK;
+            }
+
+            subscribe_client_idx_to_topic(
+                clients,
+                values[0],
+                (const char *)rec->data + sizeof values[0] + 1,
+                rec->data[sizeof values[0]] == SF ? SF : NO_SF
+            );
+
+            return OK;
+        case JOURNAL_UNSUBSCRIBE:
+            if (journal_rec_has_str(rec, sizeof values[0]) == 0) {
+                return OK;
+            }
+
+            unsubscribe_client_idx_from_topic(clients, values[0], (const char *)rec->data + sizeof values[0]);
+
+            return OK;
+        case JOURNAL_CONSUME:
+            if (rec->len != sizeof values) {
+                return OK;
+            }
+
+            memcpy(values, rec->data, sizeof values);
+            drop_topic_msgs_for_client(clients, values[1], values[0]);
+
+            return OK;
+        case JOURNAL_FRAME: {
+            size_t idxs_len = (size_t)values[0] * sizeof values[0];
+
+            if ((rec->len < sizeof values[0] + idxs_len) ||
+                (rec->len - sizeof values[0] - idxs_len > MAX_TCP_MSG_BUF_LEN)) {
+                return OK;
+            }
+
+            msg->len = (uint16_t)(rec->len - sizeof values[0] - idxs_len);
+            memcpy(msg->data, rec->data + sizeof values[0] + idxs_len, msg->len);
+
+            err_t err = OK;
+            tcp_frame_t *frame = NULL;
+
+            if ((err = create_tcp_frame(&frame, msg)) != OK) {
+                return err;
+            }
+
+            /* The journal order is the order of the messages */
+            frame->seq = journal->stats.replayed_records;
+
+            for (uint32_t iter = 0; (err == OK) && (iter < values[0]); ++iter) {
+                uint32_t idx = 0;
+
+                memcpy(&idx, rec->data + sizeof values[0] + iter * sizeof idx, sizeof idx);
+                if (idx < clients->len) {
+                    err = add_topic_msg_for_client(clients, frame, idx);
+                }
+            }
+
+            tcp_frame_release(&frame);
+
+            return err;
+        }
+        default:
+            return OK;
+    }
+}
+
+/**
+ * @brief Replays the valid records of a journal, the replay stops
+ * at the end of the written records or at the first torn record.
+ *
+ * @param journal journal structure.
+ * @param clients clients vector to restore.
+ * @return err_t OK if the journal was replayed or error otherwise.
+ */
+static err_t journal_replay(journal_t *journal, client_vec_t *clients) {
+    tcp_msg_t *msg = malloc(sizeof *msg);
+    if (msg == NULL) {
+        return JOURNAL_FAILED_ALLOCATION;
+    }
+
+    err_t err = OK;
+    size_t pos = sizeof (journal_header_t);
+
+    while (pos + sizeof (journal_rec_t) <= journal->map_len) {
+        const journal_rec_t *rec = (const journal_rec_t *)(journal->map + pos);
+
+        if ((rec->type == JOURNAL_END) ||
+            (rec->len > journal->map_len - pos - sizeof (journal_rec_t)) ||
+            (rec->sum != journal_sum(rec))) {
+            break;
+        }
+
+        if ((err = journal_apply(journal, rec, clients, msg)) != OK) {
+            break;
+        }
+
+        journal->stats.replayed_records++;
+        pos += journal_rec_size(rec->len);
+    }
+
+    free(msg);
+
+    return err;
+}
+
+/**
+ * @brief Compares two backlog messages by message order
+ * and then by client index.
+ *
+ * @param first first entry.
+ * @param second second entry.
+ * @return int sort order of the entries.
+ */
+static int journal_entry_cmp(const void *first, const void *second) {
+    const journal_entry_t *lhs = first;
+    const journal_entry_t *rhs = second;
+
+    if (lhs->seq != rhs->seq) {
+        return lhs->seq < rhs->seq ? -1 : 1;
+    }
+
+    return (lhs->client_idx > rhs->client_idx) - (lhs->client_idx < rhs->client_idx);
+}
+
+/**
+ * @brief Writes the live state of the clients into an empty journal:
+ * the clients in index order, their subscriptions and their backlogs.
+ * A message shared by several backlogs is written once.
+ *
+ * @param journal empty journal structure.
+ * @param clients restored clients vector.
+ * @return err_t OK if the state was written or error otherwise.
+ */
+static err_t journal_snapshot(journal_t *journal, client_vec_t *clients) {
+    err_t err = OK;
+    size_t entries_len = 0;
+
+    for (size_t iter = 0; (err == OK) && (iter < clients->len); ++iter) {
+        err = journal_client(journal, clients->entities[iter]->id);
+        entries_len += clients->entities[iter]->ready_msgs_len;
+    }
+
+    for (size_t iter = 0; (err == OK) && (iter < clients->len); ++iter) {
+        client_type_t *client = clients->entities[iter];
+
+        for (size_t iter_j = 0; (err == OK) && (iter_j < client->topics_len); ++iter_j) {
+            err = journal_subscribe(journal, iter, client->topics[iter_j], client->options[iter_j]);
+        }
+    }
+
+    if ((err != OK) || (entries_len == 0)) {
+        return err;
+    }
+
+    journal_entry_t *entries = malloc(sizeof *entries * entries_len);
+    if (entries == NULL) {
+        return JOURNAL_FAILED_ALLOCATION;
+    }
+
+    entries_len = 0;
+    for (size_t iter = 0; iter < clients->len; ++iter) {
+        client_type_t *client = clients->entities[iter];
+
+        for (size_t iter_j = 0; iter_j < client->ready_msgs_len; ++iter_j) {
+            entries[entries_len].seq = client->ready_msgs[iter_j]->seq;
+            entries[entries_len].client_idx = (uint32_t)iter;
+            entries[entries_len].frame = client->ready_msgs[iter_j];
+            entries_len++;
+        }
+    }
+
+    /* Every backlog keeps its order and a shared frame gets one record */
+    qsort(entries, entries_len, sizeof *entries, journal_entry_cmp);
+
+    for (size_t iter = 0; (err == OK) && (iter < entries_len); ++iter) {
+        err = journal_add_recipient(journal, entries[iter].client_idx);
+
+        if ((err == OK) && ((iter + 1 == entries_len) || (entries[iter + 1].frame != entries[iter].frame))) {
+            err = journal_frame(journal, entries[iter].frame);
+        }
+    }
+
+    free(entries);
+
+    return err;
+}
+
+/**
+ * @brief Flushes the directory of a journal file, so a renamed
+ * journal is found after a crash.
+ *
+ * @param path path of the journal file.
+ * @return err_t OK if the directory was flushed or JOURNAL_FAILED_IO otherwise.
+ */
+static err_t journal_sync_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    char *dir = slash == NULL ? strdup(".") : strndup(path, (size_t)(slash - path) + 1);
+
+    if (dir == NULL) {
+        return JOURNAL_FAILED_ALLOCATION;
+    }
+
+    int dir_fd = open(dir, O_RDONLY | O_DIRECTORY);
+    free(dir);
+
+    if (dir_fd < 0) {
+        return JOURNAL_FAILED_IO;
+    }
+
+    int ret = fsync(dir_fd);
+    close(dir_fd);
+
+    return ret < 0 ? JOURNAL_FAILED_IO : OK;
+}
+
+/**
+ * @brief Opens a journal file and replays it into an empty clients
+ * vector, all the restored clients are DEAD. The journal is then
+ * compacted into a new file with just the live state.
+ *
+ * @param journal pointer to journal structure to allocate, must be NULL.
+ * @param path path of the journal file, created if missing.
+ * @param sync_ms max delay in ms of a record flush, 0 flushes on every sync call.
+ * @param clients clients vector to restore.
+ * @return err_t OK if the journal was opened or error otherwise.
+ */
+err_t open_journal(journal_t **journal, const char *path, uint64_t sync_ms, client_vec_t *clients) {
+    if ((journal == NULL) || (*journal != NULL)) {
+        return JOURNAL_INPUT_IS_NOT_NULL;
+    }
+
+    if ((path == NULL) || (clients == NULL)) {
+        return JOURNAL_INPUT_IS_NULL;
+    }
+
+    err_t err = OK;
+    journal_t *old_journal = NULL;
+
+    if ((err = journal_open_file(&old_journal, path, 0, sync_ms)) != OK) {
+        return err;
+    }
+
+    if ((err = journal_replay(old_journal, clients)) != OK) {
+        journal_release(old_journal);
+
+        return err;
+    }
+
+    char *tmp_path = malloc(strlen(path) + sizeof ".tmp");
+    if (tmp_path == NULL) {
+        journal_release(old_journal);
+
+        return JOURNAL_FAILED_ALLOCATION;
+    }
+
+    sprintf(tmp_path, "%s.tmp", path);
+
+    /* The compacted journal replaces the old one just when it is on the disk */
+    if ((err = journal_open_file(journal, tmp_path, 1, sync_ms)) == OK) {
+        (*journal)->stats.replayed_records = old_journal->stats.replayed_records;
+
+        for (size_t iter = 0; iter < clients->len; ++iter) {
+            (*journal)->stats.replayed_frames += clients->entities[iter]->ready_msgs_len;
+        }
+
+        if (((err = journal_snapshot(*journal, clients)) != OK) ||
+            ((err = journal_sync(*journal, 1)) != OK) ||
+            (rename(tmp_path, path) < 0) ||
+            ((err = journal_sync_dir(path)) != OK)) {
+            err = err == OK ? JOURNAL_FAILED_IO : err;
+
+            close_journal(journal);
+            unlink(tmp_path);
+        }
+    }
+
+    free(tmp_path);
+    journal_release(old_journal);
+
+    return err;
+}
+
+/**
+ * @brief Flushes and closes a journal and sets it to NULL.
+ *
+ * @param journal pointer to journal structure.
+ * @return err_t OK if the journal was closed or error otherwise.
+ */
+err_t close_journal(journal_t **journal) {
+    if ((journal == NULL) || (*journal == NULL)) {
+        return JOURNAL_INPUT_IS_NULL;
+    }
+
+    err_t err = journal_sync(*journal, 1);
+
+    /* Drop the unwritten space kept for the next records */
+    if ((err == OK) && (ftruncate((*journal)->fd, (off_t)(*journal)->used) < 0)) {
+        err = JOURNAL_FAILED_IO;
+    }
+
+    journal_release(*journal);
+    *journal = NULL;
+
+    return err;
+}
+
+/**
+ * @brief Gets the time until the appended records must be flushed.
+ *
+ * @param journal journal structure.
+ * @return int timeout in ms or -1 if there is nothing to flush.
+ */
+int journal_sync_timeout(journal_t *journal) {
+    if ((journal == NULL) || (journal->synced == journal->used)) {
+        return -1;
+    }
+
+    uint64_t elapsed = journal_now_ms() - journal->last_sync_ms;
+
+    return elapsed >= journal->sync_ms ? 0 : (int)(journal->sync_ms - elapsed);
+}
+
+/**
+ * @brief Flushes the appended records if the sync delay passed.
+ *
+ * @param journal journal structure.
+ * @param force 1 to flush regardless of the delay.
+ * @return err_t OK if the records are flushed or not due yet, error otherwise.
+ */
+err_t journal_sync(journal_t *journal, uint8_t force) {
+    if (journal == NULL) {
+        return JOURNAL_INPUT_IS_NULL;
+    }
+
+    if (journal->synced == journal->used) {
+        return OK;
+    }
+
+    uint64_t now = journal_now_ms();
+
+    if ((force == 0) && (now - journal->last_sync_ms < journal->sync_ms)) {
+        return OK;
+    }
+
+    /* msync needs a page aligned start */
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = journal->synced & ~(page - 1);
+
+    if (msync(journal->map + start, journal->used - start, MS_SYNC) < 0) {
+        return JOURNAL_FAILED_IO;
+    }
+
+    journal->synced = journal->used;
+    journal->last_sync_ms = now;
+    journal->stats.syncs++;
+
+    return OK;
+}
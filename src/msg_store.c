@@ -0,0 +1,393 @@
+/**
+ * @file msg_store.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/msg_store.h"
+
+/**
+ * @brief Gets the monotonic time in milliseconds.
+ *
+ * @return uint64_t current time in ms.
+ */
+static uint64_t msg_store_now_ms(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Gets the oldest or newest live segment.
+ *
+ * @param store store structure, with at least one segment.
+ * @param newest 1 for the newest segment or 0 for the oldest one.
+ * @return msg_segment_t* pointer to the segment.
+ */
+static msg_segment_t* msg_store_segment(msg_store_t *store, uint8_t newest) {
+    size_t pos = newest == 1 ? store->seg_len - 1 : 0;
+
+    return store->segments[(store->seg_head + pos) % store->seg_capacity];
+}
+
+/**
+ * @brief Grows a ring of pointers and unwraps the pointers
+ * at the start of the new ring.
+ *
+ * @param ring pointer to the ring array.
+ * @param head pointer to the index of the first pointer.
+ * @param len number of pointers in the ring.
+ * @param capacity pointer to the capacity of the ring.
+ * @return err_t OK if the ring was grown or MSG_STORE_FAILED_ALLOCATION otherwise.
+ */
+static err_t msg_store_grow_ring(void ***ring, size_t *head, size_t len, size_t *capacity) {
+    void **ring_real = malloc(sizeof *ring_real * *capacity * REALLOC_FACTOR);
+
+    if (ring_real == NULL) {
+        return MSG_STORE_FAILED_ALLOCATION;
+    }
+
+    for (size_t iter = 0; iter < len; ++iter) {
+        ring_real[iter] = (*ring)[(*head + iter) % *capacity];
+    }
+
+    free(*ring);
+
+    *ring = ring_real;
+    *head = 0;
+    *capacity *= REALLOC_FACTOR;
+
+    return OK;
+}
+
+/**
+ * @brief Creates an empty message store.
+ *
+ * @param store pointer to store structure to allocate, must be NULL.
+ * @param max_msgs max number of retained messages or 0.
+ * @param max_bytes max bytes of the live segments or 0.
+ * @param max_age_ms max age of a retained message in ms or 0.
+ * @return err_t OK if the store was allocated or error otherwise.
+ */
+err_t create_msg_store(msg_store_t **store, size_t max_msgs, size_t max_bytes, uint64_t max_age_ms) {
+    if ((store == NULL) || (*store != NULL)) {
+        return MSG_STORE_INPUT_IS_NOT_NULL;
+    }
+
+    *store = calloc(1, sizeof **store);
+    if (*store == NULL) {
+        return MSG_STORE_FAILED_ALLOCATION;
+    }
+
+    (*store)->seg_capacity = MSG_STORE_INIT_SEGMENTS;
+    (*store)->segments = malloc(sizeof *(*store)->segments * (*store)->seg_capacity);
+
+    (*store)->rec_capacity = MSG_STORE_INIT_RECORDS;
+    (*store)->records = malloc(sizeof *(*store)->records * (*store)->rec_capacity);
+
+    if (((*store)->segments == NULL) || ((*store)->records == NULL)) {
+        free((*store)->segments);
+        free((*store)->records);
+        free(*store);
+        *store = NULL;
+
+        return MSG_STORE_FAILED_ALLOCATION;
+    }
+
+    (*store)->max_msgs = max_msgs;
+    (*store)->max_bytes = max_bytes;
+    (*store)->max_age_ms = max_age_ms;
+
+    return OK;
+}
+
+/**
+ * @brief Frees a message store and sets it to NULL.
+ *
+ * @param store pointer to store structure.
+ * @return err_t OK if the store was freed or error otherwise.
+ */
+err_t free_msg_store(msg_store_t **store) {
+    if ((store == NULL) || (*store == NULL)) {
+        return MSG_STORE_INPUT_IS_NULL;
+    }
+
+    for (size_t iter = 0; iter < (*store)->seg_len; ++iter) {
+        free((*store)->segments[((*store)->seg_head + iter) % (*store)->seg_capacity]);
+    }
+
+    while ((*store)->free_segs != NULL) {
+        msg_segment_t *next = (*store)->free_segs->next;
+
+        free((*store)->free_segs);
+        (*store)->free_segs = next;
+    }
+
+    free((*store)->segments);
+    free((*store)->records);
+    free(*store);
+    *store = NULL;
+
+    return OK;
+}
+
+/**
+ * @brief Appends a segment at the end of the ring, a recycled
+ * segment is used if there is one.
+ *
+ * @param store store structure.
+ * @return err_t OK if the segment was added or MSG_STORE_FAILED_ALLOCATION otherwise.
+ */
+static err_t msg_store_add_segment(msg_store_t *store) {
+    if ((store->seg_len == store->seg_capacity) && (msg_store_grow_ring(
+        (void ***)&store->segments,
+        &store->seg_head,
+        store->seg_len,
+        &store->seg_capacity) != OK)
+    ) {
+        return MSG_STORE_FAILED_ALLOCATION;
+    }
+
+    msg_segment_t *segment = store->free_segs;
+
+    if (segment != NULL) {
+        store->free_segs = segment->next;
+        (store->free_len)--;
+        store->stats.segments_recycled++;
+    } else {
+        segment = malloc(sizeof *segment);
+
+        if (segment == NULL) {
+            return MSG_STORE_FAILED_ALLOCATION;
+        }
+
+        store->stats.segments_allocated++;
+    }
+
+    segment->next = NULL;
+    segment->used = 0;
+    segment->live = 0;
+
+    store->segments[(store->seg_head + store->seg_len) % store->seg_capacity] = segment;
+    (store->seg_len)++;
+
+    return OK;
+}
+
+/**
+ * @brief Removes the oldest segment from the ring and keeps
+ * it for reuse or frees it if enough segments are kept.
+ *
+ * @param store store structure.
+ */
+static void msg_store_drop_segment(msg_store_t *store) {
+    msg_segment_t *segment = store->segments[store->seg_head];
+
+    store->seg_head = (store->seg_head + 1) % store->seg_capacity;
+    (store->seg_len)--;
+
+    if (store->free_len < MSG_STORE_MAX_FREE_SEGMENTS) {
+        segment->next = store->free_segs;
+        store->free_segs = segment;
+        (store->free_len)++;
+    } else {
+        free(segment);
+    }
+}
+
+/**
+ * @brief Gets room for a record after the newest message, at least
+ * UDP_RECORD_MAX_LEN bytes, so a message can be parsed in place. The
+ * record becomes a stored message just after msg_store_commit, so a
+ * record that could not be filled is reused by the next call.
+ *
+ * @param store store structure.
+ * @param record pointer to variable to set the record.
+ * @return err_t OK if a record is available or error otherwise.
+ */
+err_t msg_store_reserve(msg_store_t *store, udp_record_t **record) {
+    if ((store == NULL) || (record == NULL)) {
+        return MSG_STORE_INPUT_IS_NULL;
+    }
+
+    /* A record never spans two segments */
+    if ((store->seg_len == 0) ||
+        (MSG_STORE_SEGMENT_BYTES - msg_store_segment(store, 1)->used < UDP_RECORD_MAX_LEN)) {
+        err_t err = msg_store_add_segment(store);
+
+        if (err != OK) {
+            return err;
+        }
+    }
+
+    msg_segment_t *segment = msg_store_segment(store, 1);
+
+    *record = (udp_record_t *)((uint8_t *)segment->arena + segment->used);
+
+    return OK;
+}
+
+/**
+ * @brief Stores the record got by the last msg_store_reserve call,
+ * the record takes just its udp_record_size bytes of the arena.
+ *
+ * @param store store structure.
+ * @param seq pointer to variable to set the sequence number of the message or NULL.
+ * @return err_t OK if the record was stored or error otherwise.
+ */
+err_t msg_store_commit(msg_store_t *store, uint64_t *seq) {
+    if ((store == NULL) || (store->seg_len == 0)) {
+        return MSG_STORE_INPUT_IS_NULL;
+    }
+
+    if ((store->len == store->rec_capacity) && (msg_store_grow_ring(
+        (void ***)&store->records,
+        &store->rec_head,
+        store->len,
+        &store->rec_capacity) != OK)
+    ) {
+        return MSG_STORE_FAILED_ALLOCATION;
+    }
+
+    msg_segment_t *segment = msg_store_segment(store, 1);
+    udp_record_t *record = (udp_record_t *)((uint8_t *)segment->arena + segment->used);
+    size_t record_size = udp_record_size(record);
+
+    record->stamp = msg_store_now_ms();
+
+    segment->used += record_size;
+    (segment->live)++;
+
+    store->records[(store->rec_head + store->len) % store->rec_capacity] = record;
+    (store->len)++;
+
+    store->stats.appended++;
+    store->stats.record_bytes += record_size;
+
+    if (seq != NULL) {
+        *seq = store->first_seq + store->len - 1;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Gets a retained message by its sequence number.
+ *
+ * @param store store structure.
+ * @param seq sequence number of the message.
+ * @param record pointer to variable to set the record.
+ * @return err_t OK if the message is retained or MSG_STORE_SEQ_NOT_FOUND otherwise.
+ */
+err_t msg_store_get(msg_store_t *store, uint64_t seq, udp_record_t **record) {
+    if ((store == NULL) || (record == NULL)) {
+        return MSG_STORE_INPUT_IS_NULL;
+    }
+
+    if ((seq < store->first_seq) || (seq - store->first_seq >= store->len)) {
+        return MSG_STORE_SEQ_NOT_FOUND;
+    }
+
+    *record = store->records[(store->rec_head + (size_t)(seq - store->first_seq)) % store->rec_capacity];
+
+    return OK;
+}
+
+/**
+ * @brief Gets the sequence number of the next stored message.
+ *
+ * @param store store structure.
+ * @return uint64_t next sequence number.
+ */
+uint64_t msg_store_next_seq(msg_store_t *store) {
+    return store->first_seq + store->len;
+}
+
+/**
+ * @brief Checks if the store is over one of its retention limits.
+ *
+ * @param store store structure, with at least one message.
+ * @param now current time in ms.
+ * @return uint8_t 1 if the oldest message should expire or 0 otherwise.
+ */
+static uint8_t msg_store_over_limits(msg_store_t *store, uint64_t now) {
+    if ((store->max_msgs != 0) && (store->len > store->max_msgs)) {
+        return 1;
+    }
+
+    /* The newest segment is always kept */
+    if ((store->max_bytes != 0) && (store->seg_len > 1) &&
+        (store->seg_len * sizeof (msg_segment_t) > store->max_bytes)) {
+        return 1;
+    }
+
+    if ((store->max_age_ms != 0) &&
+        (now - store->records[store->rec_head]->stamp > store->max_age_ms)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Drops the oldest messages while the store is over one of its
+ * retention limits. The expired segments are recycled. The messages
+ * still referenced by a store-and-forward backlog are kept alive by
+ * their shared frames, not by the store.
+ *
+ * @param store store structure.
+ */
+void msg_store_expire(msg_store_t *store) {
+    if (store == NULL) {
+        return;
+    }
+
+    uint64_t now = msg_store_now_ms();
+
+    while ((store->len > 0) && (msg_store_over_limits(store, now) == 1)) {
+        msg_segment_t *segment = msg_store_segment(store, 0);
+
+        store->stats.record_bytes -= udp_record_size(store->records[store->rec_head]);
+        store->stats.expired++;
+
+        store->rec_head = (store->rec_head + 1) % store->rec_capacity;
+        (store->len)--;
+        (store->first_seq)++;
+
+        /* Every record of the oldest segment expired */
+        if ((--(segment->live) == 0) && (store->seg_len > 1)) {
+            msg_store_drop_segment(store);
+        }
+    }
+
+    /* An empty store reuses its newest segment from the start */
+    if (store->len == 0) {
+        while (store->seg_len > 1) {
+            msg_store_drop_segment(store);
+        }
+
+        if (store->seg_len == 1) {
+            msg_store_segment(store, 1)->used = 0;
+        }
+    }
+}
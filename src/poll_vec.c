@@ -24,6 +24,203 @@
 
 #include "./include/poll_vec.h"
 
+#define URING_GEN_MASK          0xFFFFFFU
+
+/**
+ * @brief Packs an operation, the generation and the fd into the user data
+ * of an io_uring operation, so the completions of a closed fd are dropped
+ * even if the fd number is reused.
+ *
+ * @param op operation type.
+ * @param gen generation of the watched fd.
+ * @param fd watched file descriptor.
+ * @return uint64_t user data of the operation.
+ */
+static uint64_t to_uring_data(poll_vec_op_t op, uint32_t gen, int fd) {
+    return ((uint64_t)op << 56) | ((uint64_t)(gen & URING_GEN_MASK) << 32) | (uint32_t)fd;
+}
+
+/**
+ * @brief Converts poll events into epoll events.
+ *
+ * @param fd_events poll events.
+ * @return uint32_t epoll events.
+ */
+static uint32_t to_epoll_events(short fd_events) {
+    uint32_t events = 0;
+
+    if ((fd_events & POLLIN) != 0) {
+        events |= EPOLLIN;
+    }
+
+    if ((fd_events & POLLOUT) != 0) {
+        events |= EPOLLOUT;
+    }
+
+    return events;
+}
+
+/**
+ * @brief Converts epoll events into poll revents.
+ *
+ * @param events epoll events.
+ * @return short poll revents.
+ */
+static short from_epoll_events(uint32_t events) {
+    short revents = 0;
+
+    if ((events & EPOLLIN) != 0) {
+        revents |= POLLIN;
+    }
+
+    if ((events & EPOLLOUT) != 0) {
+        revents |= POLLOUT;
+    }
+
+    if ((events & EPOLLERR) != 0) {
+        revents |= POLLERR;
+    }
+
+    if ((events & EPOLLHUP) != 0) {
+        revents |= POLLHUP;
+    }
+
+    return revents;
+}
+
+/**
+ * @brief Makes sure the fd indexed slots table can hold the fd.
+ *
+ * @param vec poll vector structure.
+ * @param fd file descriptor to fit in the table.
+ * @return err_t OK if the table is large enough or error otherwise.
+ */
+static err_t poll_vec_reserve_slot(poll_vec_t *vec, int fd) {
+    if ((size_t)fd < vec->slots_len) {
+        return OK;
+    }
+
+    size_t slots_len = vec->slots_len;
+    while (slots_len <= (size_t)fd) {
+        slots_len *= REALLOC_FACTOR;
+    }
+
+    poll_vec_slot_t *slots_real = realloc(vec->slots, sizeof *vec->slots * slots_len);
+    if (slots_real == NULL) {
+        return POLL_VEC_FAILED_REALLOC;
+    }
+
+    memset(slots_real + vec->slots_len, 0, sizeof *slots_real * (slots_len - vec->slots_len));
+
+    vec->slots = slots_real;
+    vec->slots_len = slots_len;
+
+    return OK;
+}
+
+/**
+ * @brief Makes sure the pfds array and the ready list can hold
+ * one more file descriptor.
+ *
+ * @param vec poll vector structure.
+ * @return err_t OK if there is space for a new fd or error otherwise.
+ */
+static err_t poll_vec_reserve_fd(poll_vec_t *vec) {
+    if (vec->nfds < vec->capacity) {
+        return OK;
+    }
+
+    nfds_t capacity = vec->capacity * REALLOC_FACTOR;
+
+    struct pollfd *pfds_real = realloc(vec->pfds, sizeof *vec->pfds * capacity);
+    if (pfds_real == NULL) {
+        return POLL_VEC_FAILED_REALLOC;
+    }
+
+    vec->pfds = pfds_real;
+
+    poll_vec_event_t *ready_real = realloc(vec->ready, sizeof *vec->ready * capacity);
+    if (ready_real == NULL) {
+        return POLL_VEC_FAILED_REALLOC;
+    }
+
+    vec->ready = ready_real;
+
+    if (vec->backend == EPOLL_BACKEND) {
+        struct epoll_event *epoll_events_real =
+            realloc(vec->epoll_events, sizeof *vec->epoll_events * capacity);
+
+        if (epoll_events_real == NULL) {
+            return POLL_VEC_FAILED_REALLOC;
+        }
+
+        vec->epoll_events = epoll_events_real;
+    }
+
+    vec->capacity = capacity;
+    vec->ready_capacity = capacity;
+
+    return OK;
+}
+
+/**
+ * @brief Queues a one-shot poll of a watched fd for the io_uring backend.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor with events.
+ * @return err_t OK if the poll was queued or error otherwise.
+ */
+static err_t poll_vec_arm_fd(poll_vec_t *vec, int fd) {
+    struct io_uring_sqe *sqe = NULL;
+    err_t err = OK;
+
+    if ((err = uring_get_sqe(vec->uring, &sqe)) != OK) {
+        return err;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = (uint16_t)vec->slots[fd].events;
+    sqe->user_data = to_uring_data(POLL_VEC_OP_POLL, vec->slots[fd].gen, fd);
+
+    return OK;
+}
+
+/**
+ * @brief Gets a submission entry for an operation on a watched
+ * fd of the io_uring backend.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor.
+ * @param op operation type.
+ * @param sqe pointer to variable to set the submission entry.
+ * @return err_t OK if the entry was found or error otherwise.
+ */
+static err_t poll_vec_get_sqe(poll_vec_t *vec, int fd, poll_vec_op_t op, struct io_uring_sqe **sqe) {
+    if (vec == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    if (vec->backend != URING_BACKEND) {
+        return POLL_VEC_FAILED_URING;
+    }
+
+    if ((fd < 0) || ((size_t)fd >= vec->slots_len) || (vec->slots[fd].used == 0)) {
+        return POLL_VEC_FD_NOT_FOUND;
+    }
+
+    err_t err = OK;
+
+    if ((err = uring_get_sqe(vec->uring, sqe)) != OK) {
+        return err;
+    }
+
+    (*sqe)->fd = fd;
+    (*sqe)->user_data = to_uring_data(op, vec->slots[fd].gen, fd);
+
+    return OK;
+}
+
 /**
  * @brief Creates a poll vector and links it to the
  * input poll vector pointer.
@@ -33,23 +230,71 @@
  * @return err_t OK if poll vector was allocated successfully or error otherwise.
  */
 err_t create_poll_vec(poll_vec_t **vec, nfds_t init_nfds) {
+    return create_poll_vec_with(vec, init_nfds, POLL_BACKEND);
+}
+
+/**
+ * @brief Creates a poll vector with the selected backend
+ * and links it to the input poll vector pointer.
+ *
+ * @param vec pointer to a NULL poll vector.
+ * @param init_nfds init capacity for the poll vector.
+ * @param backend IO multiplexing backend.
+ * @return err_t OK if poll vector was allocated successfully or error otherwise.
+ */
+err_t create_poll_vec_with(poll_vec_t **vec, nfds_t init_nfds, poll_vec_backend_t backend) {
     if ((vec == NULL) || (*vec != NULL)) {
         return POLL_VEC_INPUT_IS_NOT_NULL;
     }
 
-    *vec = malloc(sizeof **vec);
+    if (init_nfds == 0) {
+        init_nfds = 1;
+    }
+
+    /* One wait can reap many completions of the same fd */
+    if ((backend == URING_BACKEND) && (init_nfds < POLL_VEC_URING_EVENTS)) {
+        init_nfds = POLL_VEC_URING_EVENTS;
+    }
+
+    *vec = calloc(1, sizeof **vec);
     if (*vec == NULL) {
         return POLL_VEC_FAILED_ALLOCATION;
     }
 
+    (*vec)->backend = backend;
+    (*vec)->epfd = -1;
     (*vec)->nfds = 0;
     (*vec)->capacity = init_nfds;
     (*vec)->pfds = malloc(sizeof *(*vec)->pfds * (*vec)->capacity);
+    (*vec)->nready = 0;
+    (*vec)->ready_capacity = init_nfds;
+    (*vec)->ready = malloc(sizeof *(*vec)->ready * (*vec)->ready_capacity);
+    (*vec)->slots_len = INIT_POLL_VEC_SLOTS;
+    (*vec)->slots = calloc((*vec)->slots_len, sizeof *(*vec)->slots);
 
-    if ((*vec)->pfds == NULL) {
+    if (((*vec)->pfds == NULL) || ((*vec)->ready == NULL) || ((*vec)->slots == NULL)) {
+        free_poll_vec(vec);
         return POLL_VEC_FAILED_ALLOCATION;
     }
 
+    if (backend == EPOLL_BACKEND) {
+        (*vec)->epoll_events = malloc(sizeof *(*vec)->epoll_events * (*vec)->ready_capacity);
+        if ((*vec)->epoll_events == NULL) {
+            free_poll_vec(vec);
+            return POLL_VEC_FAILED_ALLOCATION;
+        }
+
+        if (((*vec)->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+            free_poll_vec(vec);
+            return POLL_VEC_FAILED_EPOLL;
+        }
+    }
+
+    if ((backend == URING_BACKEND) && (create_uring(&(*vec)->uring) != OK)) {
+        free_poll_vec(vec);
+        return POLL_VEC_FAILED_URING;
+    }
+
     return OK;
 }
 
@@ -64,14 +309,36 @@ err_t free_poll_vec(poll_vec_t **vec) {
         return POLL_VEC_INPUT_IS_NULL;
     }
 
-    for (nfds_t iter = 0; iter < (*vec)->nfds; ++iter) {
-        close((*vec)->pfds[iter].fd);
+    if ((*vec)->slots != NULL) {
+        for (size_t iter = 0; iter < (*vec)->slots_len; ++iter) {
+            if ((*vec)->slots[iter].used != 0) {
+                close((int)iter);
+            }
+        }
+
+        free((*vec)->slots);
+    }
+
+    if ((*vec)->epfd >= 0) {
+        close((*vec)->epfd);
+    }
+
+    if ((*vec)->uring != NULL) {
+        free_uring(&(*vec)->uring);
     }
 
     if ((*vec)->pfds != NULL) {
         free((*vec)->pfds);
     }
 
+    if ((*vec)->ready != NULL) {
+        free((*vec)->ready);
+    }
+
+    if ((*vec)->epoll_events != NULL) {
+        free((*vec)->epoll_events);
+    }
+
     free(*vec);
     *vec = NULL;
 
@@ -88,31 +355,187 @@ err_t free_poll_vec(poll_vec_t **vec) {
  * @return err_t OK if file descriptor was added successfully or error otherwise.
  */
 err_t poll_vec_add_fd(poll_vec_t *vec, int fd, short fd_events) {
+    return poll_vec_add_fd_data(vec, fd, fd_events, NULL);
+}
+
+/**
+ * @brief Adds a new valid file descriptor to the poll vector
+ * together with an user data pointer returned on every ready event.
+ *
+ * @param vec poll vector structure.
+ * @param fd new valid file descriptor.
+ * @param fd_events file descriptor events.
+ * @param data user data pointer, can be NULL.
+ * @return err_t OK if file descriptor was added successfully or error otherwise.
+ */
+err_t poll_vec_add_fd_data(poll_vec_t *vec, int fd, short fd_events, void *data) {
     if (vec == NULL) {
         return POLL_VEC_INPUT_IS_NULL;
     }
 
+    if (fd < 0) {
+        return POLL_VEC_FD_NOT_FOUND;
+    }
+
+    err_t err = OK;
+
     /* Adds more memory for new fds */
-    if (vec->nfds == vec->capacity) {
-        struct pollfd *pfds_real = realloc(vec->pfds, sizeof *vec->pfds * vec->capacity * REALLOC_FACTOR);
+    if ((err = poll_vec_reserve_slot(vec, fd)) != OK) {
+        return err;
+    }
 
-        if (pfds_real == NULL) {
-            return POLL_VEC_FAILED_REALLOC;
-        }
+    if ((err = poll_vec_reserve_fd(vec)) != OK) {
+        return err;
+    }
+
+    if (vec->backend == EPOLL_BACKEND) {
+        struct epoll_event event = {
+            .events = to_epoll_events(fd_events),
+            .data.fd = fd
+        };
 
-        vec->pfds = pfds_real;
-        vec->capacity *= REALLOC_FACTOR;
+        if (epoll_ctl(vec->epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            return POLL_VEC_FAILED_EPOLL;
+        }
+    } else if (vec->backend == POLL_BACKEND) {
+        vec->pfds[vec->nfds].fd = fd;
+        vec->pfds[vec->nfds].events = fd_events;
+        vec->pfds[vec->nfds].revents = 0;
     }
 
-    vec->pfds[vec->nfds].fd = fd;
-    vec->pfds[vec->nfds].events = fd_events;
-    vec->pfds[vec->nfds].revents = 0;
+    vec->slots[fd].used = 1;
+    vec->slots[fd].events = fd_events;
+    vec->slots[fd].idx = vec->nfds;
+    vec->slots[fd].data = data;
+    vec->slots[fd].gen = ++vec->gen & URING_GEN_MASK;
+
+    /* A fd without events is watched just for its operations */
+    if ((vec->backend == URING_BACKEND) && (fd_events != 0) && ((err = poll_vec_arm_fd(vec, fd)) != OK)) {
+        memset(&vec->slots[fd], 0, sizeof *vec->slots);
+        return err;
+    }
 
     (vec->nfds)++;
 
     return OK;
 }
 
+/**
+ * @brief Adds a copy of a file descriptor owned by another structure,
+ * the poll vector closes just the copy.
+ *
+ * @param vec poll vector structure.
+ * @param fd valid file descriptor to copy.
+ * @param fd_events file descriptor events.
+ * @param dup_fd pointer to variable to set the watched copy.
+ * @return err_t OK if the copy was added successfully or error otherwise.
+ */
+err_t poll_vec_add_fd_dup(poll_vec_t *vec, int fd, short fd_events, int *dup_fd) {
+    if ((vec == NULL) || (dup_fd == NULL)) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    err_t err = OK;
+
+    if ((*dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0)) < 0) {
+        return POLL_VEC_FD_NOT_FOUND;
+    }
+
+    if ((err = poll_vec_add_fd(vec, *dup_fd, fd_events)) != OK) {
+        close(*dup_fd);
+        *dup_fd = -1;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Changes the user data pointer of a watched file descriptor.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor.
+ * @param data new user data pointer.
+ * @return err_t OK if the data was changed or error otherwise.
+ */
+err_t poll_vec_set_fd_data(poll_vec_t *vec, int fd, void *data) {
+    if (vec == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    if ((fd < 0) || ((size_t)fd >= vec->slots_len) || (vec->slots[fd].used == 0)) {
+        return POLL_VEC_FD_NOT_FOUND;
+    }
+
+    vec->slots[fd].data = data;
+
+    return OK;
+}
+
+/**
+ * @brief Changes the events of a watched file descriptor.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor.
+ * @param fd_events new file descriptor events.
+ * @return err_t OK if the events were changed or error otherwise.
+ */
+err_t poll_vec_modify_fd(poll_vec_t *vec, int fd, short fd_events) {
+    if (vec == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    if ((fd < 0) || ((size_t)fd >= vec->slots_len) || (vec->slots[fd].used == 0)) {
+        return POLL_VEC_FD_NOT_FOUND;
+    }
+
+    if (vec->slots[fd].events == fd_events) {
+        return OK;
+    }
+
+    if (vec->backend == EPOLL_BACKEND) {
+        struct epoll_event event = {
+            .events = to_epoll_events(fd_events),
+            .data.fd = fd
+        };
+
+        if (epoll_ctl(vec->epfd, EPOLL_CTL_MOD, fd, &event) < 0) {
+            return POLL_VEC_FAILED_EPOLL;
+        }
+    } else if (vec->backend == URING_BACKEND) {
+        short old_events = vec->slots[fd].events;
+
+        vec->slots[fd].events = fd_events;
+
+        if (old_events == 0) {
+            return poll_vec_arm_fd(vec, fd);
+        }
+
+        /* A fired poll is armed again with the new events */
+        struct io_uring_sqe *sqe = NULL;
+        err_t err = OK;
+
+        if ((err = uring_get_sqe(vec->uring, &sqe)) != OK) {
+            return err;
+        }
+
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = to_uring_data(POLL_VEC_OP_POLL, vec->slots[fd].gen, fd);
+        sqe->user_data = to_uring_data(POLL_VEC_OP_CANCEL, 0, fd);
+
+        if (fd_events != 0) {
+            sqe->len = IORING_POLL_UPDATE_EVENTS;
+            sqe->poll32_events = (uint16_t)fd_events;
+        }
+    } else {
+        vec->pfds[vec->slots[fd].idx].events = fd_events;
+    }
+
+    vec->slots[fd].events = fd_events;
+
+    return OK;
+}
+
 /**
  * @brief Removes a file descriptor from the poll vector at a specified
  * index, the index should be valid or function will return with error.
@@ -126,7 +549,8 @@ err_t poll_vec_remove_fd(poll_vec_t *vec, nfds_t fd_idx) {
         return POLL_VEC_INPUT_IS_NULL;
     }
 
-    if (fd_idx >= vec->nfds) {
+    /* Indexes have a meaning just for the pfds array */
+    if ((vec->backend != POLL_BACKEND) || (fd_idx >= vec->nfds)) {
         return POLL_VEC_INPUT_FD_IDX_OUT_OF_BOUND;
     }
 
@@ -136,12 +560,302 @@ err_t poll_vec_remove_fd(poll_vec_t *vec, nfds_t fd_idx) {
      * end a termination for the thread
      */
     close(vec->pfds[fd_idx].fd);
+    memset(&vec->slots[vec->pfds[fd_idx].fd], 0, sizeof *vec->slots);
 
     for (; fd_idx < vec->nfds - 1; ++fd_idx) {
         vec->pfds[fd_idx] = vec->pfds[fd_idx + 1];
+        vec->slots[vec->pfds[fd_idx].fd].idx = fd_idx;
+    }
+
+    (vec->nfds)--;
+
+    return OK;
+}
+
+/**
+ * @brief Removes and closes a watched file descriptor in O(1),
+ * pending ready events of the fd are discarded and the pending
+ * io_uring operations of the fd are cancelled.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched file descriptor.
+ * @return err_t OK if file descriptor was removed or error otherwise.
+ */
+err_t poll_vec_remove_fd_by(poll_vec_t *vec, int fd) {
+    if (vec == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
     }
 
+    if ((fd < 0) || ((size_t)fd >= vec->slots_len) || (vec->slots[fd].used == 0)) {
+        return POLL_VEC_FD_NOT_FOUND;
+    }
+
+    if (vec->backend == EPOLL_BACKEND) {
+        epoll_ctl(vec->epfd, EPOLL_CTL_DEL, fd, NULL);
+    } else if (vec->backend == URING_BACKEND) {
+        /*
+         * The operations keep the socket open, so cancel all of
+         * them before the fd is closed and the kernel stops
+         * using the buffers of the pending sends
+         */
+        struct io_uring_sqe *sqe = NULL;
+
+        if (uring_get_sqe(vec->uring, &sqe) == OK) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = fd;
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+            sqe->user_data = to_uring_data(POLL_VEC_OP_CANCEL, 0, fd);
+
+            uring_submit(vec->uring);
+        }
+    } else {
+        /* Move the last pollfd into the freed position */
+        nfds_t fd_idx = vec->slots[fd].idx;
+
+        vec->pfds[fd_idx] = vec->pfds[vec->nfds - 1];
+        vec->slots[vec->pfds[fd_idx].fd].idx = fd_idx;
+    }
+
+    /*
+     * The fd number can be reused by the next accept,
+     * so drop the events that were not processed yet
+     */
+    for (nfds_t iter = 0; iter < vec->nready; ++iter) {
+        if (vec->ready[iter].fd == fd) {
+            if ((vec->ready[iter].flags & IORING_CQE_F_BUFFER) != 0) {
+                uring_release_buf(vec->uring, (uint16_t)(vec->ready[iter].flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+
+            vec->ready[iter].fd = -1;
+            vec->ready[iter].revents = 0;
+            vec->ready[iter].data = NULL;
+        }
+    }
+
+    close(fd);
+    memset(&vec->slots[fd], 0, sizeof *vec->slots);
+
     (vec->nfds)--;
 
     return OK;
 }
+
+/**
+ * @brief Submits the queued operations, waits for completions and
+ * fills the ready list with them. A fired poll is armed again for the
+ * next wait and the completions of removed fds are dropped.
+ *
+ * @param vec poll vector structure with the io_uring backend.
+ * @param timeout timeout in milliseconds or -1 to block.
+ * @return err_t OK if the wait returned (nready can be 0 on timeout)
+ * or POLL_FAILED_TIMED_OUT if the wait failed.
+ */
+static err_t poll_vec_wait_uring(poll_vec_t *vec, int timeout) {
+    struct io_uring_cqe *cqe = NULL;
+
+    /* A blocking wait returns just after a completion of an fd still watched */
+    do {
+        if (uring_wait(vec->uring, timeout) != OK) {
+            return POLL_FAILED_TIMED_OUT;
+        }
+
+        /* The completions that do not fit are reaped by the next wait */
+        while ((vec->nready < vec->ready_capacity) && ((cqe = uring_peek_cqe(vec->uring)) != NULL)) {
+            poll_vec_op_t op = (poll_vec_op_t)(cqe->user_data >> 56);
+            uint32_t gen = (uint32_t)(cqe->user_data >> 32) & URING_GEN_MASK;
+            int fd = (int)(uint32_t)cqe->user_data;
+            int32_t res = cqe->res;
+            uint32_t flags = cqe->flags;
+
+            uring_cqe_seen(vec->uring);
+
+            if (op == POLL_VEC_OP_CANCEL) {
+                continue;
+            }
+
+            if ((fd < 0) || ((size_t)fd >= vec->slots_len) ||
+                (vec->slots[fd].used == 0) || (vec->slots[fd].gen != gen)) {
+                /* The fd was removed, give back its buffer */
+
+                if ((flags & IORING_CQE_F_BUFFER) != 0) {
+                    uring_release_buf(vec->uring, (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT));
+                }
+
+                continue;
+            }
+
+            poll_vec_event_t *event = &vec->ready[vec->nready];
+
+            event->fd = fd;
+            event->revents = 0;
+            event->data = vec->slots[fd].data;
+            event->op = op;
+            event->res = res;
+            event->flags = flags;
+
+            (vec->nready)++;
+
+            if (op == POLL_VEC_OP_POLL) {
+                event->revents = res < 0 ? POLLERR : (short)res;
+
+                if ((vec->slots[fd].events != 0) && (poll_vec_arm_fd(vec, fd) != OK)) {
+                    return POLL_FAILED_TIMED_OUT;
+                }
+            }
+        }
+    } while ((vec->nready == 0) && (timeout < 0));
+
+    return OK;
+}
+
+/**
+ * @brief Waits for events on the watched file descriptors and
+ * fills the ready list of the poll vector.
+ *
+ * @param vec poll vector structure.
+ * @param timeout timeout in milliseconds or -1 to block.
+ * @return err_t OK if the wait returned (nready can be 0 on timeout)
+ * or POLL_FAILED_TIMED_OUT if the wait failed.
+ */
+err_t poll_vec_wait(poll_vec_t *vec, int timeout) {
+    if (vec == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    vec->nready = 0;
+
+    if (vec->backend == EPOLL_BACKEND) {
+        int ready = epoll_wait(vec->epfd, vec->epoll_events, (int)vec->ready_capacity, timeout);
+
+        if (ready < 0) {
+            return POLL_FAILED_TIMED_OUT;
+        }
+
+        /* Just the ready fds are visited */
+        for (int iter = 0; iter < ready; ++iter) {
+            int fd = vec->epoll_events[iter].data.fd;
+
+            vec->ready[vec->nready].fd = fd;
+            vec->ready[vec->nready].revents = from_epoll_events(vec->epoll_events[iter].events);
+            vec->ready[vec->nready].data = vec->slots[fd].data;
+            vec->ready[vec->nready].op = POLL_VEC_OP_POLL;
+            vec->ready[vec->nready].res = 0;
+            vec->ready[vec->nready].flags = 0;
+
+            (vec->nready)++;
+        }
+    } else if (vec->backend == URING_BACKEND) {
+        return poll_vec_wait_uring(vec, timeout);
+    } else {
+        int ready = poll(vec->pfds, vec->nfds, timeout);
+
+        if (ready < 0) {
+            return POLL_FAILED_TIMED_OUT;
+        }
+
+        /* Stop the scan as soon as all the ready fds were found */
+        for (nfds_t iter = 0; (iter < vec->nfds) && (vec->nready < (nfds_t)ready); ++iter) {
+            if (vec->pfds[iter].revents != 0) {
+                vec->ready[vec->nready].fd = vec->pfds[iter].fd;
+                vec->ready[vec->nready].revents = vec->pfds[iter].revents;
+                vec->ready[vec->nready].data = vec->slots[vec->pfds[iter].fd].data;
+                vec->ready[vec->nready].op = POLL_VEC_OP_POLL;
+                vec->ready[vec->nready].res = 0;
+                vec->ready[vec->nready].flags = 0;
+
+                (vec->nready)++;
+            }
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Starts a multishot accept on a watched listener socket, every
+ * accepted connection is reported as a POLL_VEC_OP_ACCEPT event. The accept
+ * must be started again when an event comes without IORING_CQE_F_MORE.
+ * Just the io_uring backend runs operations.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched listener socket.
+ * @return err_t OK if the accept was queued or error otherwise.
+ */
+err_t poll_vec_accept(poll_vec_t *vec, int fd) {
+    struct io_uring_sqe *sqe = NULL;
+    err_t err = OK;
+
+    if ((err = poll_vec_get_sqe(vec, fd, POLL_VEC_OP_ACCEPT, &sqe)) != OK) {
+        return err;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+
+    return OK;
+}
+
+/**
+ * @brief Starts a multishot receive on a watched socket, every message
+ * is received in a provided buffer of the io_uring instance and reported
+ * as a POLL_VEC_OP_RECVMSG event. The buffer must be released after the
+ * event is processed and the receive must be started again when an event
+ * comes without IORING_CQE_F_MORE.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched socket.
+ * @param hdr lengths of the address and control parts of every buffer.
+ * @return err_t OK if the receive was queued or error otherwise.
+ */
+err_t poll_vec_recvmsg(poll_vec_t *vec, int fd, struct msghdr *hdr) {
+    struct io_uring_sqe *sqe = NULL;
+    err_t err = OK;
+
+    if (hdr == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    if ((err = poll_vec_get_sqe(vec, fd, POLL_VEC_OP_RECVMSG, &sqe)) != OK) {
+        return err;
+    }
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    sqe->addr = (uint64_t)(uintptr_t)hdr;
+    sqe->len = 1;
+
+    return OK;
+}
+
+/**
+ * @brief Queues a send on a watched socket, it is submitted by the next
+ * wait call and reported as a POLL_VEC_OP_SENDMSG event. The message
+ * buffers must be kept until the event.
+ *
+ * @param vec poll vector structure.
+ * @param fd watched socket.
+ * @param hdr message to send.
+ * @return err_t OK if the send was queued or error otherwise.
+ */
+err_t poll_vec_sendmsg(poll_vec_t *vec, int fd, struct msghdr *hdr) {
+    struct io_uring_sqe *sqe = NULL;
+    err_t err = OK;
+
+    if (hdr == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    if ((err = poll_vec_get_sqe(vec, fd, POLL_VEC_OP_SENDMSG, &sqe)) != OK) {
+        return err;
+    }
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->addr = (uint64_t)(uintptr_t)hdr;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+
+    return OK;
+}
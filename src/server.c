@@ -22,27 +22,38 @@
  *
  */
 
-#include "./include/server_utils.h"
+#include "./include/server_pool.h"
 
 /**
  * @brief Main server function in order to process clients requests.
  *
- * @param argc MUST be 2 one for exec filename and one for a valid port number.
- * @param argv port number represented as a string
+ * @param argc MUST contain the exec filename, a valid port number and optional flags.
+ * @param argv port number represented as a string followed by optional flags.
  * @return int EXIT_CODE_GREEN if success or EXIT_CODE_RED otherwise
  */
 int main(int argc, char **argv) {
     setvbuf(stdout, NULL, _IONBF, BUFSIZ);
 
-    /* Checks upon right number of commands */
-    if (argc != 2) {
+    server_config_t config;
+
+    /* Checks upon right number of commands and valid options */
+    if (parse_server_config(&config, argc, argv) != OK) {
         KILL("[SERVER] Wrong cmdline input.");
     }
 
     err_t err = OK;
 
+    /* The worker threads run their own event loops */
+    if (config.workers > 1) {
+        if ((err = run_server_pool(&config)) != OK) {
+            debug_msg_and_exit(err);
+        }
+
+        return EXIT_CODE_GREEN;
+    }
+
     server_t *server = NULL;
-    err = init_server(&server, atoi(argv[1]));
+    err = init_server(&server, &config);
 
     /* Check if server is up and connected to udp and tcp sockets */
     if (err != OK) {
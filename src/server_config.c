@@ -0,0 +1,229 @@
+/**
+ * @file server_config.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/server_config.h"
+
+/**
+ * @brief Matches a backend name with a poll vector backend.
+ *
+ * @param name backend name from the command line.
+ * @param backend pointer to variable to set the backend.
+ * @return err_t OK if the name is a known backend or SERVER_INVALID_CONFIG otherwise.
+ */
+static err_t parse_backend(const char *name, poll_vec_backend_t *backend) {
+    if (strcmp(name, "poll") == 0) {
+        *backend = POLL_BACKEND;
+    } else if (strcmp(name, "epoll") == 0) {
+        *backend = EPOLL_BACKEND;
+    } else if (strcmp(name, "uring") == 0) {
+        *backend = URING_BACKEND;
+    } else {
+        return SERVER_INVALID_CONFIG;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Matches a policy name with an overflow policy.
+ *
+ * @param name policy name from the command line.
+ * @param overflow pointer to variable to set the policy.
+ * @return err_t OK if the name is a known policy or SERVER_INVALID_CONFIG otherwise.
+ */
+static err_t parse_overflow(const char *name, overflow_policy_t *overflow) {
+    if (strcmp(name, "drop-oldest") == 0) {
+        *overflow = OVERFLOW_DROP_OLDEST;
+    } else if (strcmp(name, "disconnect") == 0) {
+        *overflow = OVERFLOW_DISCONNECT;
+    } else if (strcmp(name, "spill") == 0) {
+        *overflow = OVERFLOW_SPILL;
+    } else {
+        return SERVER_INVALID_CONFIG;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Parses a strictly positive number option.
+ *
+ * @param str number from the command line.
+ * @param value pointer to variable to set the number.
+ * @return err_t OK if the number is valid or SERVER_INVALID_CONFIG otherwise.
+ */
+static err_t parse_count(const char *str, size_t *value) {
+    char *end = NULL;
+    long long count = strtoll(str, &end, 10);
+
+    if ((end == str) || (*end != '\0') || (count <= 0)) {
+        return SERVER_INVALID_CONFIG;
+    }
+
+    *value = (size_t)count;
+
+    return OK;
+}
+
+/**
+ * @brief Parses a limit option, zero means unlimited.
+ *
+ * @param str number from the command line.
+ * @param value pointer to variable to set the limit.
+ * @return err_t OK if the number is valid or SERVER_INVALID_CONFIG otherwise.
+ */
+static err_t parse_limit(const char *str, size_t *value) {
+    if (strcmp(str, "0") == 0) {
+        *value = 0;
+
+        return OK;
+    }
+
+    return parse_count(str, value);
+}
+
+/**
+ * @brief Parses the server command line into a config structure,
+ * the options that are not present keep their default values.
+ *
+ * Usage: ./server <port> [--backend poll|epoll|uring] [--udp-batch N] [--udp-drain N]
+ *                       [--queue-limit BYTES] [--overflow drop-oldest|disconnect|spill]
+ *                       [--retain-msgs N] [--retain-bytes BYTES] [--retain-age SECONDS]
+ *                       [--journal FILE] [--journal-sync MS] [--workers N]
+ *
+ * @param config pointer to config structure to fill.
+ * @param argc number of command line arguments.
+ * @param argv command line arguments.
+ * @return err_t OK if the command line is valid or SERVER_INVALID_CONFIG otherwise.
+ */
+err_t parse_server_config(server_config_t *config, int argc, char **argv) {
+    if ((config == NULL) || (argv == NULL)) {
+        return SERVER_INVALID_CONFIG;
+    }
+
+    static const struct option long_options[] = {
+        { "backend",        required_argument,  NULL,   'b' },
+        { "udp-batch",      required_argument,  NULL,   'B' },
+        { "udp-drain",      required_argument,  NULL,   'D' },
+        { "queue-limit",    required_argument,  NULL,   'q' },
+        { "overflow",       required_argument,  NULL,   'o' },
+        { "retain-msgs",    required_argument,  NULL,   'R' },
+        { "retain-bytes",   required_argument,  NULL,   'S' },
+        { "retain-age",     required_argument,  NULL,   'T' },
+        { "journal",        required_argument,  NULL,   'j' },
+        { "journal-sync",   required_argument,  NULL,   'J' },
+        { "workers",        required_argument,  NULL,   'w' },
+        { NULL,             0,                  NULL,   0   }
+    };
+
+    memset(config, 0, sizeof *config);
+    config->backend = DEFAULT_BACKEND;
+    config->udp_batch_len = DEFAULT_UDP_BATCH_LEN;
+    config->udp_drain_limit = DEFAULT_UDP_DRAIN_LIMIT;
+    config->queue_limit = DEFAULT_QUEUE_LIMIT;
+    config->overflow = DEFAULT_OVERFLOW;
+    config->retain_msgs = DEFAULT_RETAIN_MSGS;
+    config->retain_bytes = DEFAULT_RETAIN_BYTES;
+    config->retain_age = DEFAULT_RETAIN_AGE;
+    config->journal_path = NULL;
+    config->journal_sync = DEFAULT_JOURNAL_SYNC_MS;
+    config->workers = DEFAULT_WORKERS;
+
+    err_t err = OK;
+    int opt = 0;
+
+    optind = 1;
+    while ((opt = getopt_long(argc, argv, "b:B:D:q:o:R:S:T:j:J:w:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'b':
+                if ((err = parse_backend(optarg, &config->backend)) != OK) {
+                    return err;
+                }
+                break;
+            case 'B':
+                if ((err = parse_count(optarg, &config->udp_batch_len)) != OK) {
+                    return err;
+                }
+                break;
+            case 'D':
+                if ((err = parse_count(optarg, &config->udp_drain_limit)) != OK) {
+                    return err;
+                }
+                break;
+            case 'q':
+                if ((err = parse_count(optarg, &config->queue_limit)) != OK) {
+                    return err;
+                }
+                break;
+            case 'o':
+                if ((err = parse_overflow(optarg, &config->overflow)) != OK) {
+                    return err;
+                }
+                break;
+            case 'R':
+                if ((err = parse_limit(optarg, &config->retain_msgs)) != OK) {
+                    return err;
+                }
+                break;
+            case 'S':
+                if ((err = parse_limit(optarg, &config->retain_bytes)) != OK) {
+                    return err;
+                }
+                break;
+            case 'T':
+                if ((err = parse_limit(optarg, &config->retain_age)) != OK) {
+                    return err;
+                }
+                break;
+            case 'j':
+                config->journal_path = optarg;
+                break;
+            case 'J':
+                if ((err = parse_limit(optarg, &config->journal_sync)) != OK) {
+                    return err;
+                }
+                break;
+            case 'w':
+                if ((err = parse_count(optarg, &config->workers)) != OK) {
+                    return err;
+                }
+
+                if (config->workers > MAX_WORKERS) {
+                    return SERVER_INVALID_CONFIG;
+                }
+                break;
+            default:
+                return SERVER_INVALID_CONFIG;
+        }
+    }
+
+    /* The port number is the only positional argument */
+    if (optind != argc - 1) {
+        return SERVER_INVALID_CONFIG;
+    }
+
+    config->port = (uint16_t)atoi(argv[optind]);
+
+    return OK;
+}
@@ -0,0 +1,896 @@
+/**
+ * @file server_pool.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/server_pool.h"
+
+/**
+ * @brief Inits the UDP socket of the pool dispatcher.
+ *
+ * @param pool pool structure.
+ * @return int 0 if init went successfully or -1 otherwise.
+ */
+static int init_pool_udp_socket(server_pool_t *pool) {
+    struct sockaddr_in addr;
+
+    if ((pool->udp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof addr);
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(pool->config.port);
+
+    if (bind(pool->udp_socket, (const struct sockaddr *) &addr, sizeof addr) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Inits the poll vector of the pool dispatcher, it watches
+ * the stdin, the UDP socket and the done eventfd. The poll backend
+ * is used, the stdin can be a regular file.
+ *
+ * @param pool pool structure.
+ * @return int 0 if poll vector was initialized successfully or -1 otherwise.
+ */
+static int init_pool_poll_vec(server_pool_t *pool) {
+    if (create_poll_vec_with(&pool->poll_vec, INIT_NFDS, POLL_BACKEND) != OK) {
+        return -1;
+    }
+
+    /* The UDP socket is closed by the poll vector once it is watched */
+    if (poll_vec_add_fd(pool->poll_vec, pool->udp_socket, POLLIN) != OK) {
+        free_poll_vec(&pool->poll_vec);
+        return -1;
+    }
+
+    if (poll_vec_add_fd(pool->poll_vec, STDIN_FILENO, POLLIN) != OK) {
+        return -1;
+    }
+
+    /* The poll vector closes its own copy of the done eventfd */
+    if (poll_vec_add_fd_dup(pool->poll_vec, pool->done_fd, POLLIN, &pool->done_watch_fd) != OK) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Inits the match stage, its poll vector watches the
+ * ingest ring and the inbox of the stage.
+ *
+ * @param pool pool structure.
+ * @return int 0 if the match stage was initialized successfully or -1 otherwise.
+ */
+static int init_pool_match(server_pool_t *pool) {
+    pool_match_t *match = &pool->match;
+
+    match->ring_fd = -1;
+    match->inbox_fd = -1;
+    match->interest_len = INIT_POOL_INTEREST_LEN;
+
+    if ((create_shard_inbox(&match->inbox, DEFAULT_SHARD_INBOX_LIMIT) != OK) ||
+        (create_topic_table(&match->topics, INIT_TOPIC_TABLE_LEN) != OK) ||
+        ((match->interest = calloc(match->interest_len, sizeof *match->interest)) == NULL) ||
+        (create_poll_vec_with(&match->poll_vec, INIT_NFDS, POLL_BACKEND) != OK)) {
+        return -1;
+    }
+
+    /* The poll vector closes its own copies of the eventfds */
+    if ((poll_vec_add_fd_dup(match->poll_vec, pool->ring->event_fd, POLLIN, &match->ring_fd) != OK) ||
+        (poll_vec_add_fd_dup(match->poll_vec, match->inbox->event_fd, POLLIN, &match->inbox_fd) != OK)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Finds the directory slot of a client ID or the
+ * empty slot where the client ID must be added.
+ *
+ * @param directory directory slots, the length is a power of two.
+ * @param directory_len number of slots.
+ * @param id client ID.
+ * @param hash hash of the client ID.
+ * @return size_t slot index.
+ */
+static size_t pool_directory_probe(pool_client_t *directory, size_t directory_len,
+    const char *id, uint64_t hash) {
+    size_t slot = (size_t)hash & (directory_len - 1);
+
+    while ((directory[slot].id != NULL) &&
+        ((directory[slot].hash != hash) || (strcmp(directory[slot].id, id) != 0))) {
+        slot = (slot + 1) & (directory_len - 1);
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Doubles the number of directory slots.
+ *
+ * @param pool pool structure.
+ * @return err_t OK if the directory was resized or error otherwise.
+ */
+static err_t pool_directory_grow(server_pool_t *pool) {
+    size_t directory_len = pool->directory_len * REALLOC_FACTOR;
+
+    pool_client_t *directory = calloc(directory_len, sizeof *directory);
+    if (directory == NULL) {
+        return SERVER_POOL_FAILED_ALLOCATION;
+    }
+
+    for (size_t iter = 0; iter < pool->directory_len; ++iter) {
+        if (pool->directory[iter].id != NULL) {
+            directory[pool_directory_probe(
+                directory,
+                directory_len,
+                pool->directory[iter].id,
+                pool->directory[iter].hash)] = pool->directory[iter];
+        }
+    }
+
+    free(pool->directory);
+
+    pool->directory = directory;
+    pool->directory_len = directory_len;
+
+    return OK;
+}
+
+/**
+ * @brief Gets the worker shard that owns a client ID, a new
+ * client ID is owned by the claiming shard.
+ *
+ * @param pool pool structure.
+ * @param id client ID.
+ * @param shard_id index of the claiming shard.
+ * @param owner pointer to variable to set the index of the owner shard.
+ * @return err_t OK if the owner was found or error otherwise.
+ */
+err_t server_pool_claim_client(server_pool_t *pool, const char *id, size_t shard_id, size_t *owner) {
+    if ((pool == NULL) || (id == NULL) || (owner == NULL)) {
+        return SERVER_POOL_INPUT_IS_NULL;
+    }
+
+    err_t err = OK;
+    uint64_t hash = hash_str(id);
+
+    pthread_mutex_lock(&pool->lock);
+
+    /* Keep the directory at most half full */
+    if ((2 * (pool->directory_used + 1) > pool->directory_len) && ((err = pool_directory_grow(pool)) != OK)) {
+        pthread_mutex_unlock(&pool->lock);
+
+        return err;
+    }
+
+    pool_client_t *entry = &pool->directory[pool_directory_probe(pool->directory, pool->directory_len, id, hash)];
+
+    if (entry->id == NULL) {
+        if ((entry->id = strdup(id)) == NULL) {
+            pthread_mutex_unlock(&pool->lock);
+
+            return SERVER_POOL_FAILED_ALLOCATION;
+        }
+
+        entry->hash = hash;
+        entry->shard_id = shard_id;
+
+        pool->directory_used++;
+    }
+
+    *owner = entry->shard_id;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return OK;
+}
+
+/**
+ * @brief Posts a client that completed its handshake to the inbox
+ * of its owner shard, the owner shard registers the client.
+ *
+ * @param pool pool structure.
+ * @param owner index of the owner shard.
+ * @param fd socket of the client.
+ * @param proto wire format of the client.
+ * @param id client ID.
+ * @param addr address of the client.
+ * @return err_t OK if the client was posted or error otherwise.
+ */
+err_t server_pool_handoff_client(server_pool_t *pool, size_t owner, int fd, tcp_proto_t proto,
+    const char *id, const struct sockaddr_in *addr) {
+    if ((pool == NULL) || (id == NULL) || (owner >= pool->workers)) {
+        return SERVER_POOL_INPUT_IS_NULL;
+    }
+
+    shard_msg_t msg = { .type = SHARD_MSG_CLIENT, .proto = (uint8_t)proto, .fd = fd, .addr = *addr };
+
+    err_t err = shard_inbox_post(pool->shards[owner]->inbox, &msg, id, strlen(id) + 1);
+
+    if (err == OK) {
+        __atomic_add_fetch(&pool->handoffs, 1, __ATOMIC_RELAXED);
+    }
+
+    return err;
+}
+
+/**
+ * @brief Tells the match stage whether a worker shard has
+ * subscribers of a topic.
+ *
+ * @param pool pool structure.
+ * @param shard_id index of the worker shard.
+ * @param topic topic name.
+ * @param interest 1 if the shard has subscribers of the topic or 0 otherwise.
+ * @return err_t OK if the update was posted or error otherwise.
+ */
+err_t server_pool_post_interest(server_pool_t *pool, size_t shard_id, const char *topic, uint8_t interest) {
+    if ((pool == NULL) || (topic == NULL) || (shard_id >= pool->workers)) {
+        return SERVER_POOL_INPUT_IS_NULL;
+    }
+
+    shard_msg_t msg = {
+        .type = interest == 1 ? SHARD_MSG_WATCH_TOPIC : SHARD_MSG_UNWATCH_TOPIC,
+        .fd = -1,
+        .shard = (uint32_t)shard_id
+    };
+
+    return shard_inbox_post(pool->match.inbox, &msg, topic, strlen(topic) + 1);
+}
+
+/**
+ * @brief Event loop of a worker thread, the loop stops when the
+ * shard gets the exit message or on error. The dispatcher is
+ * signalled when the loop stops.
+ *
+ * @param arg worker shard.
+ * @return void* NULL.
+ */
+static void *run_server_worker(void *arg) {
+    server_t *server = arg;
+    err_t err = OK;
+
+    stage_busy(&server->stage);
+
+    loop {
+        stage_idle(&server->stage);
+
+        if ((err = wait_for_ready_fds(server)) != OK) {
+            debug_msg(err);
+            break;
+        }
+
+        stage_busy(&server->stage);
+
+        if ((err = process_ready_fds(server)) != OK) {
+            debug_msg(err);
+            break;
+        }
+
+        if (server->stopped == 1) {
+            break;
+        }
+    }
+
+    eventfd_write(server->pool->done_fd, 1);
+
+    return NULL;
+}
+
+/**
+ * @brief Gets the interest mask of a topic, the masks array
+ * grows with the topics seen by the match stage.
+ *
+ * @param match match stage structure.
+ * @param topic topic name.
+ * @param mask pointer to variable to set the mask of the topic.
+ * @return err_t OK if the mask was found or error otherwise.
+ */
+static err_t pool_match_interest(pool_match_t *match, const char *topic, uint64_t **mask) {
+    uint32_t topic_id = 0;
+
+    if (topic_table_intern(match->topics, topic, &topic_id) != OK) {
+        return SERVER_POOL_FAILED_ALLOCATION;
+    }
+
+    if (topic_id >= match->interest_len) {
+        size_t new_len = match->interest_len << 1;
+
+        while (new_len <= topic_id) {
+            new_len <<= 1;
+        }
+
+        uint64_t *new_interest = realloc(match->interest, new_len * sizeof *new_interest);
+
+        if (new_interest == NULL) {
+            return SERVER_POOL_FAILED_ALLOCATION;
+        }
+
+        memset(new_interest + match->interest_len, 0, (new_len - match->interest_len) * sizeof *new_interest);
+
+        match->interest = new_interest;
+        match->interest_len = new_len;
+    }
+
+    *mask = &match->interest[topic_id];
+
+    return OK;
+}
+
+/**
+ * @brief Routes the records of the ingest ring to the rings of the
+ * shards with subscribers of their topics. Every shard ring is published
+ * once per chunk of records, a full shard ring drops the record just
+ * for its shard.
+ *
+ * @param pool pool structure.
+ * @return err_t OK if the records were routed or error otherwise.
+ */
+static err_t route_udp_records(server_pool_t *pool) {
+    err_t err = OK;
+    pool_match_t *match = &pool->match;
+    uint8_t *data = NULL;
+    size_t len = 0;
+    size_t records = 0;
+    uint64_t dirty = 0;
+
+    spsc_ring_ack(pool->ring);
+
+    while (spsc_ring_next(pool->ring, &data, &len) == OK) {
+        udp_record_t *record = (udp_record_t *)data;
+        uint64_t *mask = NULL;
+
+        if ((err = pool_match_interest(match, (char *)data + udp_record_size(record), &mask)) != OK) {
+            return err;
+        }
+
+        if (*mask == 0) {
+            match->unmatched++;
+        }
+
+        for (uint64_t shards = *mask; shards != 0; shards &= shards - 1) {
+            size_t shard = (size_t)__builtin_ctzll(shards);
+            spsc_ring_t *ring = pool->shards[shard]->ring;
+            uint8_t *entry = NULL;
+
+            if (spsc_ring_reserve(ring, len, &entry) != OK) {
+                continue;
+            }
+
+            memcpy(entry, data, len);
+            spsc_ring_commit(ring, len);
+
+            dirty |= (uint64_t)1 << shard;
+            match->routed++;
+        }
+
+        if (++records == pool->config.udp_batch_len) {
+            for (; dirty != 0; dirty &= dirty - 1) {
+                spsc_ring_publish(pool->shards[__builtin_ctzll(dirty)]->ring);
+            }
+
+            records = 0;
+        }
+    }
+
+    for (; dirty != 0; dirty &= dirty - 1) {
+        spsc_ring_publish(pool->shards[__builtin_ctzll(dirty)]->ring);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Prints the counters of the match stage.
+ *
+ * @param pool pool structure.
+ */
+static void print_pool_match_stats(server_pool_t *pool) {
+    pool_match_t *match = &pool->match;
+    uint64_t dropped = 0;
+
+    for (size_t iter = 0; iter < pool->workers; ++iter) {
+        dropped += pool->shards[iter]->ring->full;
+    }
+
+    flockfile(stdout);
+
+    printf(
+        "match: busy %.1f%%, ring depth %zu, max depth %" PRIu64 ", capacity %zu, records %" PRIu64
+        ", ring batches %" PRIu64 ", topics %" PRIu32 ", routed %" PRIu64 ", unmatched %" PRIu64
+        ", ring drops %" PRIu64 ".\n",
+        stage_busy_percent(&match->stage), spsc_ring_depth(pool->ring), pool->ring->max_depth,
+        pool->ring->capacity, pool->ring->entries, pool->ring->batches, match->topics->len,
+        match->routed, match->unmatched, dropped
+    );
+
+    funlockfile(stdout);
+}
+
+/**
+ * @brief Processes the messages posted to the match stage, the
+ * interest updates change the routing of the next records.
+ *
+ * @param pool pool structure.
+ * @param stopped pointer to variable to set if the stage must stop.
+ * @return err_t OK if the messages were processed or error otherwise.
+ */
+static err_t process_pool_match_inbox(server_pool_t *pool, uint8_t *stopped) {
+    err_t err = OK;
+    pool_match_t *match = &pool->match;
+    uint8_t *buf = NULL;
+    size_t len = 0;
+
+    if ((err = shard_inbox_take(match->inbox, &buf, &len)) != OK) {
+        return err;
+    }
+
+    for (size_t offset = 0; offset < len;) {
+        shard_msg_t *msg = (shard_msg_t *)(buf + offset);
+        uint64_t *mask = NULL;
+
+        offset += msg->size;
+
+        switch (msg->type) {
+            case SHARD_MSG_WATCH_TOPIC:
+            case SHARD_MSG_UNWATCH_TOPIC:
+                if ((err = pool_match_interest(match, msg->data, &mask)) != OK) {
+                    return err;
+                }
+
+                if (msg->type == SHARD_MSG_WATCH_TOPIC) {
+                    *mask |= (uint64_t)1 << msg->shard;
+                } else {
+                    *mask &= ~((uint64_t)1 << msg->shard);
+                }
+                break;
+            case SHARD_MSG_STATS:
+                print_pool_match_stats(pool);
+                break;
+            case SHARD_MSG_EXIT:
+                *stopped = 1;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Event loop of the match stage thread, the loop stops when
+ * the stage gets the exit message or on error. The dispatcher is
+ * signalled when the loop stops.
+ *
+ * @param arg pool structure.
+ * @return void* NULL.
+ */
+static void *run_pool_match(void *arg) {
+    server_pool_t *pool = arg;
+    pool_match_t *match = &pool->match;
+    uint8_t stopped = 0;
+    err_t err = OK;
+
+    stage_busy(&match->stage);
+
+    while ((stopped == 0) && (err == OK)) {
+        stage_idle(&match->stage);
+
+        /* Should not timeout */
+        if ((poll_vec_wait(match->poll_vec, -1) != OK) || (match->poll_vec->nready == 0)) {
+            err = POLL_FAILED_TIMED_OUT;
+            break;
+        }
+
+        stage_busy(&match->stage);
+
+        for (nfds_t iter = 0; (iter < match->poll_vec->nready) && (err == OK); ++iter) {
+            poll_vec_event_t *event = &match->poll_vec->ready[iter];
+
+            if ((event->revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+
+            if (event->fd == match->inbox_fd) {
+                err = process_pool_match_inbox(pool, &stopped);
+            } else if (event->fd == match->ring_fd) {
+                err = route_udp_records(pool);
+            }
+        }
+    }
+
+    if (err != OK) {
+        debug_msg(err);
+    }
+
+    eventfd_write(pool->done_fd, 1);
+
+    return NULL;
+}
+
+/**
+ * @brief Posts a message without data to the match stage
+ * and to every worker shard.
+ *
+ * @param pool pool structure.
+ * @param type type of the message.
+ */
+static void post_to_stages(server_pool_t *pool, shard_msg_type_t type) {
+    shard_msg_t msg = { .type = (uint8_t)type, .fd = -1 };
+
+    if (pool->match.inbox != NULL) {
+        shard_inbox_post(pool->match.inbox, &msg, NULL, 0);
+    }
+
+    for (size_t iter = 0; (pool->shards != NULL) && (iter < pool->workers); ++iter) {
+        if ((pool->shards[iter] != NULL) && (pool->shards[iter]->inbox != NULL)) {
+            shard_inbox_post(pool->shards[iter]->inbox, &msg, NULL, 0);
+        }
+    }
+}
+
+/**
+ * @brief Stops the worker threads and frees the resources of the pool.
+ *
+ * @param pool pointer to pool structure.
+ */
+static void free_server_pool(server_pool_t **pool) {
+    pool_match_t *match = &(*pool)->match;
+
+    post_to_stages(*pool, SHARD_MSG_EXIT);
+
+    if (match->running == 1) {
+        pthread_join(match->thread, NULL);
+    }
+
+    for (size_t iter = 0; iter < (*pool)->running; ++iter) {
+        pthread_join((*pool)->threads[iter], NULL);
+    }
+
+    for (size_t iter = 0; ((*pool)->shards != NULL) && (iter < (*pool)->workers); ++iter) {
+        if ((*pool)->shards[iter] != NULL) {
+            free_server(&(*pool)->shards[iter]);
+        }
+    }
+
+    if (match->poll_vec != NULL) {
+        free_poll_vec(&match->poll_vec);
+    }
+
+    if (match->inbox != NULL) {
+        free_shard_inbox(&match->inbox);
+    }
+
+    if (match->topics != NULL) {
+        free_topic_table(&match->topics);
+    }
+
+    if ((*pool)->ring != NULL) {
+        free_spsc_ring(&(*pool)->ring);
+    }
+
+    if ((*pool)->poll_vec != NULL) {
+        free_poll_vec(&(*pool)->poll_vec);
+    } else if ((*pool)->udp_socket >= 0) {
+        close((*pool)->udp_socket);
+    }
+
+    if ((*pool)->done_fd >= 0) {
+        close((*pool)->done_fd);
+    }
+
+    if ((*pool)->udp_batch != NULL) {
+        free_udp_batch(&(*pool)->udp_batch);
+    }
+
+    for (size_t iter = 0; ((*pool)->directory != NULL) && (iter < (*pool)->directory_len); ++iter) {
+        free((*pool)->directory[iter].id);
+    }
+
+    pthread_mutex_destroy(&(*pool)->lock);
+
+    free(match->interest);
+    free((*pool)->directory);
+    free((*pool)->shards);
+    free((*pool)->threads);
+    free((*pool)->cmd);
+    free(*pool);
+    *pool = NULL;
+}
+
+/**
+ * @brief Allocates the pool, its dispatcher resources and its worker
+ * shards. The worker threads are not started.
+ *
+ * @param pool pointer to pool structure, MUST be NULL.
+ * @param config startup options containing a valid port number.
+ * @return err_t OK if the pool was initialized or error otherwise.
+ */
+static err_t init_server_pool(server_pool_t **pool, const server_config_t *config) {
+    err_t err = OK;
+
+    *pool = calloc(1, sizeof **pool);
+    if (*pool == NULL) {
+        return SERVER_POOL_FAILED_ALLOCATION;
+    }
+
+    (*pool)->config = *config;
+    (*pool)->workers = config->workers;
+    (*pool)->udp_socket = -1;
+    (*pool)->done_fd = -1;
+    (*pool)->done_watch_fd = -1;
+    (*pool)->directory_len = INIT_POOL_DIRECTORY_LEN;
+
+    pthread_mutex_init(&(*pool)->lock, NULL);
+
+    (*pool)->shards = calloc((*pool)->workers, sizeof *(*pool)->shards);
+    (*pool)->threads = calloc((*pool)->workers, sizeof *(*pool)->threads);
+    (*pool)->directory = calloc((*pool)->directory_len, sizeof *(*pool)->directory);
+    (*pool)->cmd = calloc(MAX_CMD_LEN, sizeof *(*pool)->cmd);
+
+    if (((*pool)->shards == NULL) || ((*pool)->threads == NULL) ||
+        ((*pool)->directory == NULL) || ((*pool)->cmd == NULL) ||
+        (create_udp_batch(&(*pool)->udp_batch, config->udp_batch_len) != OK)) {
+        free_server_pool(pool);
+
+        return SERVER_POOL_FAILED_ALLOCATION;
+    }
+
+    if (init_pool_udp_socket(*pool) < 0) {
+        free_server_pool(pool);
+
+        return SERVER_FAILED_UDP;
+    }
+
+    if ((((*pool)->done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) ||
+        (init_pool_poll_vec(*pool) < 0)) {
+        free_server_pool(pool);
+
+        return SERVER_FAILED_POLL_VEC;
+    }
+
+    /* The shards tell the match stage about their restored subscriptions */
+    if ((create_spsc_ring(&(*pool)->ring, DEFAULT_SPSC_RING_LEN) != OK) ||
+        (init_pool_match(*pool) < 0)) {
+        free_server_pool(pool);
+
+        return SERVER_POOL_FAILED_ALLOCATION;
+    }
+
+    for (size_t iter = 0; iter < (*pool)->workers; ++iter) {
+        if ((err = init_server_shard(&(*pool)->shards[iter], config, *pool, iter)) != OK) {
+            free_server_pool(pool);
+
+            return err;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Drains the UDP socket with batched recvmmsg calls and parses
+ * every datagram into a udp record of the ingest ring, the topic name
+ * follows the record. The ring is published once per batch, a full
+ * ring drops the datagram.
+ *
+ * @param pool pool structure.
+ * @return err_t OK if the datagrams were ingested or error otherwise.
+ */
+static err_t ingest_udp_datagrams(server_pool_t *pool) {
+    err_t err = OK;
+    udp_batch_t *batch = pool->udp_batch;
+    size_t drained = 0;
+    char topic[MAX_TOPIC_LEN + 1] = { 0 };
+
+    while (drained < pool->config.udp_drain_limit) {
+        size_t nmsgs = 0;
+
+        if ((err = udp_batch_recv(
+            batch,
+            pool->udp_socket,
+            pool->config.udp_drain_limit - drained,
+            &nmsgs)) != OK
+        ) {
+            return err;
+        }
+
+        if (nmsgs == 0) {
+            break;
+        }
+
+        for (size_t iter = 0; iter < nmsgs; ++iter) {
+            uint8_t *entry = NULL;
+
+            if (spsc_ring_reserve(pool->ring, UDP_RECORD_MAX_LEN + sizeof topic, &entry) != OK) {
+                continue;
+            }
+
+            udp_record_t *record = (udp_record_t *)entry;
+
+            if (parse_udp_type_from(record, &batch->addrs[iter], udp_batch_buf(batch, iter), topic) != OK) {
+                batch->stats.parse_errors++;
+                continue;
+            }
+
+            size_t record_size = udp_record_size(record);
+            size_t topic_len = strlen(topic) + 1;
+
+            memcpy(entry + record_size, topic, topic_len);
+            spsc_ring_commit(pool->ring, record_size + topic_len);
+        }
+
+        spsc_ring_publish(pool->ring);
+
+        drained += nmsgs;
+
+        /* A partial batch means the socket has no datagrams left */
+        if (nmsgs < batch->len) {
+            break;
+        }
+    }
+
+    if (drained >= pool->config.udp_drain_limit) {
+        batch->stats.drain_limit_hits++;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Prints the ingest stage counters and asks the match
+ * stage and every worker shard to print their own counters.
+ *
+ * @param pool pool structure.
+ */
+static void print_server_pool_stats(server_pool_t *pool) {
+    udp_batch_stats_t *udp = &pool->udp_batch->stats;
+
+    flockfile(stdout);
+
+    printf(
+        "pool: workers %zu, handoffs %" PRIu64 ".\n",
+        pool->workers, __atomic_load_n(&pool->handoffs, __ATOMIC_RELAXED)
+    );
+
+    printf(
+        "ingest: busy %.1f%%, datagrams %" PRIu64 ", batches %" PRIu64 ", max batch %" PRIu64
+        ", drain limit hits %" PRIu64 ", parse errors %" PRIu64 ", ring drops %" PRIu64 ".\n",
+        stage_busy_percent(&pool->stage), udp->datagrams, udp->batches, udp->max_batch,
+        udp->drain_limit_hits, udp->parse_errors, pool->ring->full
+    );
+
+    funlockfile(stdout);
+
+    post_to_stages(pool, SHARD_MSG_STATS);
+}
+
+/**
+ * @brief Receives an input command from the stdin, the stats
+ * command prints the pool counters.
+ *
+ * @param pool pool structure.
+ * @return uint8_t 1 if command is exit or 0 otherwise.
+ */
+static uint8_t check_if_pool_exit(server_pool_t *pool) {
+    if (fgets(pool->cmd, MAX_CMD_LEN, stdin) == NULL) {
+        return 0;
+    }
+
+    if (strncmp(pool->cmd, STATS_CMD, STATS_CMD_LEN) == 0) {
+        print_server_pool_stats(pool);
+        return 0;
+    }
+
+    return (uint8_t)(strncmp(pool->cmd, EXIT_CMD, EXIT_CMD_LEN) == 0);
+}
+
+/**
+ * @brief Runs the server with a pool of worker threads until the
+ * exit command is received or a worker thread stops.
+ *
+ * @param config startup options containing a valid port number.
+ * @return err_t OK if the pool ran and stopped successfully or error otherwise.
+ */
+err_t run_server_pool(const server_config_t *config) {
+    if (config == NULL) {
+        return SERVER_INVALID_CONFIG;
+    }
+
+    if (config->port == 0) {
+        return INVALID_PORT_NUMBER;
+    }
+
+    err_t err = OK;
+    server_pool_t *pool = NULL;
+
+    if ((err = init_server_pool(&pool, config)) != OK) {
+        return err;
+    }
+
+    if (pthread_create(&pool->match.thread, NULL, run_pool_match, pool) != 0) {
+        free_server_pool(&pool);
+
+        return SERVER_POOL_FAILED_THREAD;
+    }
+
+    pool->match.running = 1;
+
+    for (; pool->running < pool->workers; ++pool->running) {
+        if (pthread_create(&pool->threads[pool->running], NULL, run_server_worker, pool->shards[pool->running]) != 0) {
+            free_server_pool(&pool);
+
+            return SERVER_POOL_FAILED_THREAD;
+        }
+    }
+
+    uint8_t stopped = 0;
+
+    stage_busy(&pool->stage);
+
+    while ((stopped == 0) && (err == OK)) {
+        stage_idle(&pool->stage);
+
+        /* Should not timeout */
+        if ((poll_vec_wait(pool->poll_vec, -1) != OK) || (pool->poll_vec->nready == 0)) {
+            err = POLL_FAILED_TIMED_OUT;
+            break;
+        }
+
+        stage_busy(&pool->stage);
+
+        for (nfds_t iter = 0; (iter < pool->poll_vec->nready) && (stopped == 0); ++iter) {
+            poll_vec_event_t *event = &pool->poll_vec->ready[iter];
+
+            if ((event->revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+
+            if (event->fd == pool->udp_socket) {
+                /* Parse the UDP messages for the match stage */
+
+                err = ingest_udp_datagrams(pool);
+            } else if (event->fd == STDIN_FILENO) {
+                stopped = check_if_pool_exit(pool);
+            } else {
+                /* A stage thread stopped, stop the whole pool */
+
+                stopped = 1;
+            }
+        }
+    }
+
+    free_server_pool(&pool);
+
+    return err;
+}
@@ -23,6 +23,7 @@
  */
 
 #include "./include/server_utils.h"
+#include "./include/server_pool.h"
 
 /**
  * @brief Inits a UDP socket for the server.
@@ -55,7 +56,9 @@ static int init_server_udp_socket(server_t *server, const uint16_t hport) {
 }
 
 /**
- * @brief Inits a TCP socket for the server.
+ * @brief Inits a TCP socket for the server. The listeners of the
+ * worker shards share the port, the kernel balances the new
+ * connections between them.
  *
  * @param server server structure.
  * @param hport server port number.
@@ -71,6 +74,11 @@ static int init_server_tcp_socket(server_t *server, const uint16_t hport) {
         return -1;
     }
 
+    if ((server->pool != NULL) &&
+        (setsockopt(server->tcp_socket, SOL_SOCKET, SO_REUSEPORT, &(int){1}, sizeof (int)) < 0)) {
+        return -1;
+    }
+
     memset(&server->tcp_addr, 0, sizeof server->tcp_addr);
 
     server->tcp_addr.sin_family = AF_INET;
@@ -94,29 +102,58 @@ static int init_server_tcp_socket(server_t *server, const uint16_t hport) {
 
 /**
  * @brief Inits the poll vector for the server and adds the stdin and UDP, TCP server socket.
+ * A worker shard watches its inbox and its ring instead of the stdin and the UDP socket.
+ * The io_uring backend runs a multishot accept on the TCP socket and a multishot
+ * receive into provided buffers on the UDP socket instead of watching them.
  *
  * @param server server structure.
- * @return int 0 if poll vector was initialized successfully or -1 otherwise.
+ * @param backend IO multiplexing backend of the poll vector.
+ * @return int 0 if poll vector was initialized successfully, -2 if
+ * the backend cannot watch the stdin or -1 otherwise.
  */
-static int init_server_poll_vec(server_t *server) {
-    if (create_poll_vec(&server->poll_vec, INIT_NFDS) != OK) {
+static int init_server_poll_vec_with(server_t *server, poll_vec_backend_t backend) {
+    if (create_poll_vec_with(&server->poll_vec, INIT_NFDS, backend) != OK) {
         return -1;
     }
 
-    /* Add stdin file descriptor */
-    if (poll_vec_add_fd(server->poll_vec, STDIN_FILENO, POLLIN) != OK) {
-        free_poll_vec(&server->poll_vec);
-        return -1;
-    }
+    if (server->pool != NULL) {
+        /* The poll vector closes its own copies of the eventfds */
+        if ((poll_vec_add_fd_dup(server->poll_vec, server->inbox->event_fd, POLLIN, &server->inbox_fd) != OK) ||
+            (poll_vec_add_fd_dup(server->poll_vec, server->ring->event_fd, POLLIN, &server->ring_fd) != OK)) {
+            free_poll_vec(&server->poll_vec);
+            return -1;
+        }
+    } else {
+        /* Add stdin file descriptor, nothing is closed if it fails */
+        if (poll_vec_add_fd(server->poll_vec, STDIN_FILENO, POLLIN) != OK) {
+            free_poll_vec(&server->poll_vec);
+            return -2;
+        }
 
-    /* Add the UDP server socket file descriptor */
-    if (poll_vec_add_fd(server->poll_vec, server->udp_socket, POLLIN) != OK) {
-        free_poll_vec(&server->poll_vec);
-        return -1;
+        /* Add the UDP server socket file descriptor */
+        if (backend == URING_BACKEND) {
+            server->udp_hdr.msg_namelen = sizeof (struct sockaddr_in);
+
+            if ((poll_vec_add_fd(server->poll_vec, server->udp_socket, 0) != OK) ||
+                (uring_add_bufs(server->poll_vec->uring, URING_UDP_BUFS, URING_UDP_BUF_LEN) != OK) ||
+                (poll_vec_recvmsg(server->poll_vec, server->udp_socket, &server->udp_hdr) != OK)) {
+                free_poll_vec(&server->poll_vec);
+                return -1;
+            }
+        } else if (poll_vec_add_fd(server->poll_vec, server->udp_socket, POLLIN) != OK) {
+            free_poll_vec(&server->poll_vec);
+            return -1;
+        }
     }
 
     /* Add the TCP server socket file descriptor */
-    if (poll_vec_add_fd(server->poll_vec, server->tcp_socket, POLLIN) != OK) {
+    if (backend == URING_BACKEND) {
+        if ((poll_vec_add_fd(server->poll_vec, server->tcp_socket, 0) != OK) ||
+            (poll_vec_accept(server->poll_vec, server->tcp_socket) != OK)) {
+            free_poll_vec(&server->poll_vec);
+            return -1;
+        }
+    } else if (poll_vec_add_fd(server->poll_vec, server->tcp_socket, POLLIN) != OK) {
         free_poll_vec(&server->poll_vec);
         return -1;
     }
@@ -124,6 +161,36 @@ static int init_server_poll_vec(server_t *server) {
     return 0;
 }
 
+/**
+ * @brief Inits the poll vector for the server with the configured backend.
+ * If the kernel does not support the io_uring backend the server falls back
+ * to the epoll backend. If the epoll backend cannot watch the fds (for example
+ * the stdin is a regular file) the server falls back to the poll backend.
+ *
+ * @param server server structure.
+ * @return int 0 if poll vector was initialized successfully or -1 otherwise.
+ */
+static int init_server_poll_vec(server_t *server) {
+    int ret = init_server_poll_vec_with(server, server->config.backend);
+
+    if ((ret < 0) && (server->config.backend == URING_BACKEND)) {
+        DEBUG("[SERVER] Io_uring backend is not available, falling back to epoll.");
+
+        server->config.backend = EPOLL_BACKEND;
+        ret = init_server_poll_vec_with(server, EPOLL_BACKEND);
+    }
+
+    if ((ret != -2) || (server->config.backend == POLL_BACKEND)) {
+        return ret < 0 ? -1 : 0;
+    }
+
+    DEBUG("[SERVER] Epoll backend cannot watch stdin, falling back to poll.");
+
+    server->config.backend = POLL_BACKEND;
+
+    return init_server_poll_vec_with(server, POLL_BACKEND);
+}
+
 /**
  * @brief Inits the required buffers, structures in order to maintain the
  * connection with the clients as protocol packages structures to send and
@@ -133,21 +200,21 @@ static int init_server_poll_vec(server_t *server) {
  * @return int 0 if the allocation went successfully or -1 otherwise.
  */
 static int init_server_buffers(server_t *server) {
-    server->buf = malloc(sizeof *server->buf * MAX_SERVER_BUFLEN);
-    if (server->buf == NULL) {
+    server->udp_batch = NULL;
+    if (create_udp_batch(&server->udp_batch, server->config.udp_batch_len) != OK) {
         return -1;
     }
 
     server->cmd = malloc(sizeof *server->cmd * MAX_CMD_LEN);
     if (server->cmd == NULL) {
-        free(server->buf);
+        free_udp_batch(&server->udp_batch);
 
         return -1;
     }
 
     server->send_msg = malloc(sizeof *server->send_msg);
     if (server->send_msg == NULL) {
-        free(server->buf);
+        free_udp_batch(&server->udp_batch);
         free(server->cmd);
 
         return -1;
@@ -155,18 +222,21 @@ static int init_server_buffers(server_t *server) {
 
     server->recv_msg = malloc(sizeof *server->recv_msg);
     if (server->recv_msg == NULL) {
-        free(server->buf);
+        free_udp_batch(&server->udp_batch);
         free(server->cmd);
         free(server->send_msg);
 
         return -1;
     }
 
-    server->udp_msgs_len = 0;
-    server->udp_msgs_capacity = INIT_UDP_MSGS_LEN;
-    server->udp_msgs = malloc(sizeof *server->udp_msgs * INIT_UDP_MSGS_LEN);
-    if (server->udp_msgs == NULL) {
-        free(server->buf);
+    server->msg_store = NULL;
+    if (create_msg_store(
+        &server->msg_store,
+        server->config.retain_msgs,
+        server->config.retain_bytes,
+        (uint64_t)server->config.retain_age * 1000) != OK
+    ) {
+        free_udp_batch(&server->udp_batch);
         free(server->cmd);
         free(server->send_msg);
         free(server->recv_msg);
@@ -175,7 +245,7 @@ static int init_server_buffers(server_t *server) {
     }
 
     /* Clear junk bytes from the structures */
-    memset(server->buf, 0, MAX_SERVER_BUFLEN);
+    memset(&server->queue_stats, 0, sizeof server->queue_stats);
     memset(server->cmd, 0, MAX_CMD_LEN);
     memset(server->send_msg, 0, sizeof *server->send_msg);
     memset(server->recv_msg, 0, sizeof *server->recv_msg);
@@ -184,19 +254,79 @@ static int init_server_buffers(server_t *server) {
 }
 
 /**
- * @brief Inits the server by binding two sockets one for UDP and one for TCP connection.
+ * @brief Releases the datagram source of the server, the UDP
+ * socket or the inbox and the ring of a worker shard.
+ *
+ * @param server server structure.
+ */
+static void free_server_udp_source(server_t *server) {
+    if (server->udp_socket >= 0) {
+        close(server->udp_socket);
+    }
+
+    if (server->inbox != NULL) {
+        free_shard_inbox(&server->inbox);
+    }
+
+    if (server->ring != NULL) {
+        free_spsc_ring(&server->ring);
+    }
+}
+
+/**
+ * @brief Opens the journal of the server, every worker shard
+ * keeps its clients in its own journal file.
+ *
+ * @param server server structure.
+ * @return err_t OK if the journal was opened or is not configured
+ * or error otherwise.
+ */
+static err_t open_server_journal(server_t *server) {
+    const char *path = server->config.journal_path;
+
+    if (path == NULL) {
+        return OK;
+    }
+
+    if (server->pool == NULL) {
+        return open_journal(&server->journal, path, server->config.journal_sync, server->clients);
+    }
+
+    char *shard_path = malloc(strlen(path) + 24);
+    if (shard_path == NULL) {
+        return JOURNAL_FAILED_ALLOCATION;
+    }
+
+    sprintf(shard_path, "%s.%zu", path, server->shard_id);
+
+    err_t err = open_journal(&server->journal, shard_path, server->config.journal_sync, server->clients);
+
+    free(shard_path);
+
+    return err;
+}
+
+/**
+ * @brief Inits a server or a worker shard of a server pool.
  *
  * @param server pointer to server structure, MUST be NULL.
- * @param hport a valid port number to open the connection.
+ * @param config startup options containing a valid port number.
+ * @param pool pool of the worker shard or NULL.
+ * @param shard_id index of the worker shard.
  * @return err_t OK if the server was allocated and initialized successfully or
  * error otherwise.
  */
-err_t init_server(server_t **server, const uint16_t hport) {
+static err_t init_server_with(server_t **server, const server_config_t *config,
+    struct server_pool_s *pool, size_t shard_id) {
     if (*server != NULL) {
         return SERVER_INPUT_IS_NOT_NULL;
     }
 
-    if (hport == 0) {
+    if (config == NULL) {
+        return SERVER_INVALID_CONFIG;
+    }
+
+    if (config->port == 0) {
         return INVALID_PORT_NUMBER;
     }
 
@@ -205,6 +335,22 @@ err_t init_server(server_t **server, const uint16_t hport) {
         return SERVER_FAILED_ALLOCATION;
     }
 
+    (*server)->config = *config;
+    (*server)->pool = pool;
+    (*server)->shard_id = shard_id;
+    (*server)->udp_socket = -1;
+    (*server)->inbox = NULL;
+    (*server)->inbox_fd = -1;
+    (*server)->ring = NULL;
+    (*server)->ring_fd = -1;
+    (*server)->stopped = 0;
+    (*server)->send_list = NULL;
+    (*server)->send_list_len = 0;
+    (*server)->send_list_capacity = 0;
+
+    memset(&(*server)->udp_hdr, 0, sizeof (*server)->udp_hdr);
+    memset(&(*server)->stage, 0, sizeof (*server)->stage);
+
     if (init_server_buffers(*server) < 0) {
         free(*server);
         *server = NULL;
@@ -212,25 +358,42 @@ err_t init_server(server_t **server, const uint16_t hport) {
         return SERVER_FAILED_ALLOCATION;
     }
 
-    if (init_server_udp_socket(*server, hport) < 0) {
-        free((*server)->buf);
+    /* The worker shards get the udp records through their ring */
+    if ((pool != NULL) &&
+        ((create_shard_inbox(&(*server)->inbox, DEFAULT_SHARD_INBOX_LIMIT) != OK) ||
+        (create_spsc_ring(&(*server)->ring, DEFAULT_SPSC_RING_LEN) != OK))) {
+        free_server_udp_source(*server);
+        free_udp_batch(&(*server)->udp_batch);
+        free((*server)->cmd);
+        free((*server)->send_msg);
+        free((*server)->recv_msg);
+        free_msg_store(&(*server)->msg_store);
+        free(*server);
+        *server = NULL;
+
+        return SERVER_FAILED_SHARD_INBOX;
+    }
+
+    if ((pool == NULL) && (init_server_udp_socket(*server, config->port) < 0)) {
+        free_server_udp_source(*server);
+        free_udp_batch(&(*server)->udp_batch);
         free((*server)->cmd);
         free((*server)->send_msg);
         free((*server)->recv_msg);
-        free((*server)->udp_msgs);
+        free_msg_store(&(*server)->msg_store);
         free(*server);
         *server = NULL;
 
         return SERVER_FAILED_UDP;
     }
 
-    if (init_server_tcp_socket(*server, hport) < 0) {
-        close((*server)->udp_socket);
-        free((*server)->buf);
+    if (init_server_tcp_socket(*server, config->port) < 0) {
+        free_server_udp_source(*server);
+        free_udp_batch(&(*server)->udp_batch);
         free((*server)->cmd);
         free((*server)->send_msg);
         free((*server)->recv_msg);
-        free((*server)->udp_msgs);
+        free_msg_store(&(*server)->msg_store);
         free(*server);
         *server = NULL;
 
@@ -239,13 +402,13 @@ err_t init_server(server_t **server, const uint16_t hport) {
 
     (*server)->poll_vec = NULL;
     if (init_server_poll_vec(*server) < 0) {
-        close((*server)->udp_socket);
+        free_server_udp_source(*server);
         close((*server)->tcp_socket);
-        free((*server)->buf);
+        free_udp_batch(&(*server)->udp_batch);
         free((*server)->cmd);
         free((*server)->send_msg);
         free((*server)->recv_msg);
-        free((*server)->udp_msgs);
+        free_msg_store(&(*server)->msg_store);
         free(*server);
         *server = NULL;
 
@@ -253,14 +416,14 @@ err_t init_server(server_t **server, const uint16_t hport) {
     }
 
     (*server)->clients = NULL;
-    if (create_clients_vec(&(*server)->clients, INIT_CLIENTS) != OK) {
-        close((*server)->udp_socket);
+    if (create_clients_vec(&(*server)->clients, INIT_CLIENTS, config->queue_limit) != OK) {
+        free_server_udp_source(*server);
         close((*server)->tcp_socket);
-        free((*server)->buf);
+        free_udp_batch(&(*server)->udp_batch);
         free((*server)->cmd);
         free((*server)->send_msg);
         free((*server)->recv_msg);
-        free((*server)->udp_msgs);
+        free_msg_store(&(*server)->msg_store);
         free_poll_vec(&(*server)->poll_vec);
         free(*server);
         *server = NULL;
@@ -268,9 +431,88 @@ err_t init_server(server_t **server, const uint16_t hport) {
         return SERVER_FAILED_CLIENTS_VEC;
     }
 
+    /* Restore the clients of the previous run */
+    (*server)->journal = NULL;
+    if (open_server_journal(*server) != OK) {
+        free_server_udp_source(*server);
+        close((*server)->tcp_socket);
+        free_udp_batch(&(*server)->udp_batch);
+        free((*server)->cmd);
+        free((*server)->send_msg);
+        free((*server)->recv_msg);
+        free_msg_store(&(*server)->msg_store);
+        free_poll_vec(&(*server)->poll_vec);
+        free_clients_vec(&(*server)->clients);
+        free(*server);
+        *server = NULL;
+
+        return SERVER_FAILED_JOURNAL;
+    }
+
+    /* The restored clients reconnect to this worker shard */
+    for (size_t iter = 0; (pool != NULL) && (iter < (*server)->clients->len); ++iter) {
+        size_t owner = shard_id;
+
+        if (server_pool_claim_client(pool, (*server)->clients->entities[iter]->id, shard_id, &owner) != OK) {
+            free_server(server);
+
+            return SERVER_POOL_FAILED_ALLOCATION;
+        }
+
+        if (owner != shard_id) {
+            fprintf(stderr, "[SERVER] Client %s is restored by worker %zu.\n",
+                (*server)->clients->entities[iter]->id, owner);
+        }
+    }
+
+    /* The match stage routes the records of the restored subscriptions */
+    for (uint32_t iter = 0; (pool != NULL) && (iter < (*server)->clients->topic_table->len); ++iter) {
+        topic_entry_t *topic = &(*server)->clients->topic_table->entries[iter];
+
+        if ((topic->subs_len > 0) && (server_pool_post_interest(pool, shard_id, topic->name, 1) != OK)) {
+            free_server(server);
+
+            return SERVER_POOL_FAILED_ALLOCATION;
+        }
+    }
+
     return OK;
 }
 
+/**
+ * @brief Inits the server by binding two sockets one for UDP and one for TCP connection.
+ *
+ * @param server pointer to server structure, MUST be NULL.
+ * @param config startup options containing a valid port number.
+ * @return err_t OK if the server was allocated and initialized successfully or
+ * error otherwise.
+ */
+err_t init_server(server_t **server, const server_config_t *config) {
+    return init_server_with(server, config, NULL, 0);
+}
+
+/**
+ * @brief Inits a worker shard of a server pool. The shard has no UDP
+ * socket and does not read the stdin, it gets the parsed udp records
+ * matching its subscriptions from its ring. Its TCP listener shares the port with the other shards through
+ * SO_REUSEPORT and its journal file gets the ".<shard_id>" suffix.
+ *
+ * @param server pointer to server structure, MUST be NULL.
+ * @param config startup options containing a valid port number.
+ * @param pool pool of the worker shard.
+ * @param shard_id index of the worker shard.
+ * @return err_t OK if the shard was allocated and initialized successfully or
+ * error otherwise.
+ */
+err_t init_server_shard(server_t **server, const server_config_t *config,
+    struct server_pool_s *pool, size_t shard_id) {
+    if (pool == NULL) {
+        return SERVER_POOL_INPUT_IS_NULL;
+    }
+
+    return init_server_with(server, config, pool, shard_id);
+}
+
 /**
  * @brief Frees the resources allocated by the server and closes all the connections
  * which generates closing actions for every active client.
@@ -288,8 +530,8 @@ err_t free_server(server_t **server) {
         free_poll_vec(&(*server)->poll_vec);
     }
 
-    if ((*server)->buf != NULL) {
-        free((*server)->buf);
+    if ((*server)->udp_batch != NULL) {
+        free_udp_batch(&(*server)->udp_batch);
     }
 
     if ((*server)->cmd != NULL) {
@@ -304,14 +546,28 @@ err_t free_server(server_t **server) {
         free((*server)->recv_msg);
     }
 
-    if ((*server)->udp_msgs != NULL) {
-        free((*server)->udp_msgs);
+    if ((*server)->msg_store != NULL) {
+        free_msg_store(&(*server)->msg_store);
+    }
+
+    if ((*server)->journal != NULL) {
+        close_journal(&(*server)->journal);
     }
 
     if ((*server)->clients != NULL) {
         free_clients_vec(&(*server)->clients);
     }
 
+    if ((*server)->inbox != NULL) {
+        free_shard_inbox(&(*server)->inbox);
+    }
+
+    if ((*server)->ring != NULL) {
+        free_spsc_ring(&(*server)->ring);
+    }
+
+    free((*server)->send_list);
+
     free(*server);
     *server = NULL;
 
@@ -321,7 +577,8 @@ err_t free_server(server_t **server) {
 /**
  * @brief Poll the available fds, the poll timeout is set to -1.
  * If the function returns with POLL_FAILED_TIMED_OUT the connection
- * is wrong or the fds is unavilable.
+ * is wrong or the fds is unavilable. While the journal has records
+ * to flush the poll times out when the flush is due.
  *
  * @param this server structure.
  * @return err_t OK if atleast one fd is available for specified events.
@@ -335,8 +592,11 @@ err_t wait_for_ready_fds(server_t *this) {
         return POLL_VEC_INPUT_IS_NULL;
     }
 
-    /* Should not timeout */
-    if (poll(this->poll_vec->pfds, this->poll_vec->nfds, -1) <= 0) {
+    int timeout = journal_sync_timeout(this->journal);
+
+    /* Should not timeout, unless the journal must be flushed */
+    if ((poll_vec_wait(this->poll_vec, timeout) != OK) ||
+        ((this->poll_vec->nready == 0) && (timeout < 0))) {
         return POLL_FAILED_TIMED_OUT;
     }
 
@@ -344,51 +604,55 @@ err_t wait_for_ready_fds(server_t *this) {
 }
 
 /**
- * @brief Parses a udp_type_t class into a continuous buffer to send over
+ * @brief Parses a udp message record into a continuous buffer to send over
  * a TCP connection.
  *
  * @param this server structure.
- * @param msg pointer to udp_type_t class in order to parse.
+ * @param record pointer to udp message record in order to parse.
  * @return err_t OK if message was parsed correctly or
  * error otherwise.
  */
-static err_t pack_topic_to_tcp_msg(server_t *this, udp_type_t *msg) {
+static err_t pack_topic_to_tcp_msg(server_t *this, udp_record_t *record) {
+    char ip[INET_ADDRSTRLEN];
+
+    inet_ntop(AF_INET, &record->ip, ip, sizeof ip);
+
     this->send_msg->len = snprintf(
         this->send_msg->data,
         MAX_TCP_MSG_BUF_LEN,
         "%s:%hu - %s -",
-        inet_ntoa(msg->addr.sin_addr),
-        ntohs(msg->addr.sin_port),
-        msg->topic
+        ip,
+        ntohs(record->port),
+        this->clients->topic_table->entries[record->topic_id].name
     );
 
-    switch (msg->type) {
+    switch (record->type) {
         case INT:
             this->send_msg->len += snprintf(
                 this->send_msg->data + this->send_msg->len,
                 MAX_TCP_MSG_BUF_LEN - this->send_msg->len,
-                " INT - %d", msg->data.INT
+                " INT - %d", udp_record_int(record)
             );
             break;
         case SHORT_REAL:
             this->send_msg->len += snprintf(
                 this->send_msg->data + this->send_msg->len,
                 MAX_TCP_MSG_BUF_LEN - this->send_msg->len,
-                " SHORT_REAL - %.2f", msg->data.SHORT_REAL
+                " SHORT_REAL - %.2f", udp_record_short_real(record)
             );
             break;
         case FLOAT:
             this->send_msg->len += snprintf(
                 this->send_msg->data + this->send_msg->len,
                 MAX_TCP_MSG_BUF_LEN - this->send_msg->len,
-                " FLOAT - %f", msg->data.FLOAT
+                " FLOAT - %f", udp_record_float(record)
             );
             break;
         case STRING:
             this->send_msg->len += snprintf(
                 this->send_msg->data + this->send_msg->len,
                 MAX_TCP_MSG_BUF_LEN - this->send_msg->len,
-                " STRING - %s", msg->data.STRING
+                " STRING - %s", record->payload
             );
             break;
         default:
@@ -398,36 +662,72 @@ static err_t pack_topic_to_tcp_msg(server_t *this, udp_type_t *msg) {
     return OK;
 }
 
+/**
+ * @brief Tells the match stage whether the worker shard has
+ * subscribers of a topic, the match stage routes the records
+ * of a topic just to the shards with subscribers.
+ *
+ * @param this server structure.
+ * @param topic topic name.
+ */
+static void post_topic_interest(server_t *this, const char *topic) {
+    err_t err = OK;
+    uint32_t topic_id = 0;
+    uint8_t interest = (uint8_t)((topic_table_find(this->clients->topic_table, topic, &topic_id) == OK) &&
+        (this->clients->topic_table->entries[topic_id].subs_len > 0));
+
+    if ((err = server_pool_post_interest(this->pool, this->shard_id, topic, interest)) != OK) {
+        debug_msg(err);
+    }
+}
+
 /**
  * @brief Processes a TCP message from the client side, the message
  * is parsed into internal structures and additional function are called
  * to process the request (subscribe/unsubscribe).
  *
+ * The applied subscriptions are appended to the journal, in a server
+ * pool the match stage is told about them.
+ *
  * @param this server structure.
- * @param client_fd valid tcp socket file descriptor assigned for a client.
+ * @param client active client record.
  * @return err_t OK if the message was processed successfully or error otherwise.
  */
-static err_t process_server_tcp_msg(server_t *this, int client_fd) {
+static err_t process_server_tcp_msg(server_t *this, client_type_t *client) {
+    err_t err = OK;
     char *cmd = this->recv_msg->data;
     char *topic = this->recv_msg->data + strlen(cmd) + 1;
 
     if (strcmp(cmd, "subscribe") == 0) {
         /* Process a subscribe action */
 
-        return subscribe_client_to_topic(
-            this->clients,
-            client_fd,
-            topic,
-            *(uint8_t *)(this->recv_msg->data + this->recv_msg->len - 1) == 0 ? NO_SF : SF
-        );
+        client_options_t sf = *(uint8_t *)(this->recv_msg->data + this->recv_msg->len - 1) == 0 ? NO_SF : SF;
+
+        if ((err = subscribe_client_to_topic(this->clients, client->fd, topic, sf)) != OK) {
+            return err;
+        }
+
+        if (this->pool != NULL) {
+            post_topic_interest(this, topic);
+        }
+
+        if (this->journal != NULL) {
+            return journal_subscribe(this->journal, client->idx, topic, sf);
+        }
     } else if (strcmp(cmd, "unsubscribe") == 0) {
         /* Process an unsubscribe action */
 
-        return unsubscribe_client_from_topic(
-            this->clients,
-            client_fd,
-            topic
-        );
+        if ((err = unsubscribe_client_from_topic(this->clients, client->fd, topic)) != OK) {
+            return err;
+        }
+
+        if (this->pool != NULL) {
+            post_topic_interest(this, topic);
+        }
+
+        if (this->journal != NULL) {
+            return journal_unsubscribe(this->journal, client->idx, topic);
+        }
     } else {
         return SERVER_UNKNOWN_COMMAND;
     }
@@ -436,355 +736,1171 @@ static err_t process_server_tcp_msg(server_t *this, int client_fd) {
 }
 
 /**
- * @brief Adds a UDP message into the udp messages queue.
- * Internal local storage to store udp messages for futher
- * processing or for Store and Forward functionality.
+ * @brief Adds a UDP message into the message store.
+ * The datagram is parsed in place into the store arena and its
+ * topic is interned, a record that could not be parsed is not stored.
  *
  * @param this server structure.
+ * @param buf datagram bytes received from the UDP client.
+ * @param addr address of the UDP client.
  * @return err_t OK if the udp message was added successfully or
  * error otherwise.
  */
-static err_t add_server_udp_msg(server_t *this) {
+static err_t add_server_udp_msg(server_t *this, char *buf, struct sockaddr_in *addr) {
     err_t err = OK;
+    udp_record_t *record = NULL;
+    char topic[MAX_TOPIC_LEN];
 
-    /* Adds more memory for new udp messages */
-    if (this->udp_msgs_len == this->udp_msgs_capacity) {
-        udp_type_t *udp_msgs_real = realloc(
-            this->udp_msgs,
-            sizeof *this->udp_msgs * this->udp_msgs_capacity * REALLOC_FACTOR
-        );
-
-        if (udp_msgs_real == NULL) {
-            return SERVER_COULD_NOT_ADD_NEW_UDP;
-        }
-
-        this->udp_msgs = udp_msgs_real;
-        this->udp_msgs_capacity *= REALLOC_FACTOR;
+    /* Get room for a record without moving the retained messages */
+    if (msg_store_reserve(this->msg_store, &record) != OK) {
+        return SERVER_COULD_NOT_ADD_NEW_UDP;
     }
 
-    /*
-     * Clear the current space for the udp message
-     * and parse the informations into it
-     */
-    memset(&this->udp_msgs[this->udp_msgs_len], 0, sizeof *this->udp_msgs);
-    if ((err = parse_udp_type_from(
-        &this->udp_msgs[this->udp_msgs_len],
-        &this->udp_addr_client,
-        this->buf)) != OK
-    ) {
+    if ((err = parse_udp_type_from(record, addr, buf, topic)) != OK) {
         return err;
     }
 
-    (this->udp_msgs_len)++;
+    /* The record keeps just the topic id */
+    if (topic_table_intern(this->clients->topic_table, topic, &record->topic_id) != OK) {
+        return SERVER_COULD_NOT_ADD_NEW_UDP;
+    }
+
+    if (msg_store_commit(this->msg_store, NULL) != OK) {
+        return SERVER_COULD_NOT_ADD_NEW_UDP;
+    }
 
     return OK;
 }
 
 /**
- * @brief Sends a new topic message to all subscribed clients.
- * If one client is disconnected, but has the store-and-forward
- * functionality the a pointer to the message will be stacked
- * in a local client queue and upon reconnection the message will be sent.
+ * @brief Adds a udp record parsed by the ingest stage into the message store.
  *
  * @param this server structure.
- * @return err_t OK if the udp message was sent to all active clients or
+ * @param record parsed udp record.
+ * @param topic topic name of the record.
+ * @return err_t OK if the udp record was added successfully or
  * error otherwise.
  */
-static err_t transmit_topic_to_clients(server_t *this) {
-    err_t err = OK;
+static err_t add_server_udp_record(server_t *this, const udp_record_t *record, const char *topic) {
+    udp_record_t *stored = NULL;
 
-    /* Get the message ready for shipping */
-    if ((err = pack_topic_to_tcp_msg(this, &this->udp_msgs[this->udp_msgs_len - 1]))) {
-        return err;
+    if (msg_store_reserve(this->msg_store, &stored) != OK) {
+        return SERVER_COULD_NOT_ADD_NEW_UDP;
     }
 
-    /* Iterate over all active/dead clients */
-    for (size_t iter = 0; iter < this->clients->len; ++iter) {
-
-        /* Iterate over client's topics */
-        for (size_t iter_j = 0; iter_j < this->clients->entities[iter].topics_len; ++iter_j) {
-            if (strcmp(
-                this->udp_msgs[this->udp_msgs_len - 1].topic,
-                this->clients->entities[iter].topics[iter_j]) == 0
-            ) {
-                /* Client is subscribed to the received topic */
-
-                if (this->clients->entities[iter].status == ACTIVE) {
-                    /* Client is active, send the package */
-
-                    if ((err = send_tcp_msg(
-                        this->clients->entities[iter].fd,
-                        (void *)this->send_msg,
-                        sizeof *this->send_msg)) != OK
-                    ) {
-                        debug_msg(err);
-                    }
-                } else if (this->clients->entities[iter].options[iter_j] == SF) {
-                    /* Client is dead, however has the store-and-forward option */
-
-                    if ((err = add_topic_msg_for_client(
-                        this->clients,
-                        &this->udp_msgs[this->udp_msgs_len - 1],
-                        iter)) != OK
-                    ) {
-                        return err;
-                    }
-                }
+    memcpy(stored, record, udp_record_size(record));
 
-                /*
-                 * If the topic was found do not
-                 * iterate over the rest of topics
-                 */
-                break;
-            }
-        }
+    if ((topic_table_intern(this->clients->topic_table, topic, &stored->topic_id) != OK) ||
+        (msg_store_commit(this->msg_store, NULL) != OK)) {
+        return SERVER_COULD_NOT_ADD_NEW_UDP;
     }
 
     return OK;
 }
 
 /**
- * @brief Upon reconnecting with a client the stacked messages will
- * will be sent to the client. If the client closes its connection the
- * rest of the messages from the queue will wait for another reconnection.
- *
- * The process repeats every time there is a reconnection and any messages
- * are ready for sending.
+ * @brief Closes the connection of an active client, the client
+ * keeps its subscriptions and its store-and-forward backlog.
  *
  * @param this server structure.
- * @param client_fd new valid tcp socket file descriptor for the client.
- * @return err_t OK if any of the udp messages were send to the client
- * or error otherwise.
+ * @param client active client record.
  */
-static err_t retransmit_topics_to_client(server_t *this, int client_fd) {
+static void disconnect_client(server_t *this, client_type_t *client) {
     err_t err = OK;
+    int client_fd = client->fd;
+    size_t client_idx = 0;
 
-    /* Check if the client was ever connected to the server */
-    for (size_t iter = 0; iter < this->clients->len; ++iter) {
-        if (this->clients->entities[iter].fd == client_fd) {
-            size_t remaining_msgs = this->clients->entities[iter].ready_msgs_len;
-
-            /*
-             * Start sending topics messages until sent all
-             * or interrupted by closing connection
-             */
-            for (; remaining_msgs > 0; remaining_msgs--) {
+    /* The pending sends are cancelled before their frames are released */
+    poll_vec_remove_fd_by(this->poll_vec, client_fd);
 
-                /* Pack the message */
-                if ((err = pack_topic_to_tcp_msg(this, this->clients->entities[iter].ready_msgs[remaining_msgs - 1]))) {
-                    this->clients->entities[iter].ready_msgs_len = remaining_msgs;
-                    return err;
-                }
+    if ((err = close_active_client(this->clients, client_fd, &client_idx)) != OK) {
+        debug_msg(err);
+    }
 
-                /* Send the message over the client file descriptor */
-                if ((err = send_tcp_msg(client_fd, (void *)this->send_msg, sizeof *this->send_msg)) != OK) {
-                    this->clients->entities[iter].ready_msgs_len = remaining_msgs;
-                    debug_msg(err);
+    printf("Client %s disconnected.\n", client->id);
+}
 
-                    break;
-                }
-            }
+/**
+ * @brief Adds a client to the clients sent to after this wakeup.
+ *
+ * @param this server structure.
+ * @param client active client record.
+ * @return err_t OK if the client was added or error otherwise.
+ */
+static err_t list_client_send(server_t *this, client_type_t *client) {
+    if (client->send_listed == 1) {
+        return OK;
+    }
 
-            /* No udp messages left */
-            this->clients->entities[iter].ready_msgs_len = 0;
+    if (this->send_list_len == this->send_list_capacity) {
+        size_t capacity = this->send_list_capacity == 0 ? INIT_CLIENTS : this->send_list_capacity * REALLOC_FACTOR;
+        client_type_t **send_list = realloc(this->send_list, sizeof *send_list * capacity);
 
-            return OK;
+        if (send_list == NULL) {
+            return SERVER_FAILED_ALLOCATION;
         }
+
+        this->send_list = send_list;
+        this->send_list_capacity = capacity;
     }
 
-    /* Client could not be found in the server */
-    return CLIENTS_VEC_CLIENT_NOT_FOUND;
+    this->send_list[this->send_list_len++] = client;
+    client->send_listed = 1;
+
+    return OK;
 }
 
 /**
- * @brief Receives a message from the client and processes it.
- * The stdin fd is NOT processed here.
- * Message can be processed both from udp and tcp sockets, if
- * the ready socket is udp then the message will be processed and a POLLOUT
- * will be generated for the clients subscribed at the desired topic.
- * The udp message is saved internally in case a new client subscribes to the topic,
- * ot the udp message was not send due to closed connection (SF functionality).
- *
- * In case of a TCP POLLIN the server will process the message without sending
- * any messages back.
+ * @brief Watches the client for POLLOUT just while its outbound
+ * queue has frames, otherwise the client is watched just for POLLIN.
+ * With the io_uring backend the queue is sent after this wakeup instead.
  *
  * @param this server structure.
- * @return err_t OK if the messages were processed successfully or error otherwise.
+ * @param client active client record.
+ * @return err_t OK if the events were updated or error otherwise.
  */
-err_t process_ready_fds(server_t *this) {
-    if (this == NULL) {
-        return SERVER_INPUT_IS_NULL;
+static err_t watch_client_queue(server_t *this, client_type_t *client) {
+    if (client->writer.bytes > this->queue_stats.max_queued_bytes) {
+        this->queue_stats.max_queued_bytes = client->writer.bytes;
     }
 
-    if (this->poll_vec == NULL) {
-        return POLL_VEC_INPUT_IS_NULL;
+    if (this->poll_vec->backend == URING_BACKEND) {
+        return client->writer.len > 0 ? list_client_send(this, client) : OK;
     }
 
+    return poll_vec_modify_fd(
+        this->poll_vec,
+        client->fd,
+        client->writer.len > 0 ? POLLIN | POLLOUT : POLLIN
+    );
+}
+
+/**
+ * @brief Moves the stacked messages of a client into its outbound
+ * queue, in the order they were stacked, until the queue is full.
+ *
+ * @param this server structure.
+ * @param client active client record.
+ * @return err_t OK if the messages were queued or
+ * TCP_FAILED_SEND_RECV if the connection is closed.
+ */
+static err_t refill_client_queue(server_t *this, client_type_t *client) {
     err_t err = OK;
-    for (nfds_t iter = 1; iter < this->poll_vec->nfds; ++iter) {
-        if ((this->poll_vec->pfds[iter].revents & POLLIN) != 0) {
-            if (this->poll_vec->pfds[iter].fd == this->udp_socket) {
-                /* Process an UDP message */
-
-                ssize_t udp_bytes = recvfrom(
-                    this->udp_socket,
-                    this->buf,
-                    MAX_SERVER_BUFLEN,
-                    0,
-                    (struct sockaddr *) &this->udp_addr_client,
-                    &(socklen_t){sizeof this->udp_addr_client}
-                );
-
-                if (udp_bytes == 0) {
-                    if ((err = poll_vec_remove_fd(this->poll_vec, iter)) != OK) {
-                        return err;
-                    }
+    size_t sent_msgs = 0;
 
-                    iter--;
-                } else {
+    for (; sent_msgs < client->ready_msgs_len; ++sent_msgs) {
+        err = tcp_writer_send(client->fd, &client->writer, client->ready_msgs[sent_msgs]);
 
-                    /* Add udp message to the server local storage */
-                    if ((err = add_server_udp_msg(this)) != OK) {
-                        return err;
-                    }
+        if ((err != OK) && (err != TCP_WOULD_BLOCK)) {
+            break;
+        }
 
-                    /* Transmit the udp message according to above protocol */
-                    if ((err = transmit_topic_to_clients(this)) != OK) {
-                        return err;
-                    }
-                }
-            } else if (this->poll_vec->pfds[iter].fd == this->tcp_socket) {
-                /* Connect a new client to the server */
-
-                struct sockaddr_in new_client;
-                memset(&new_client, 0, sizeof new_client);
-
-                int new_client_fd = accept(
-                    this->tcp_socket,
-                    (struct sockaddr *) &new_client,
-                    &(socklen_t){sizeof new_client}
-                );
-
-                if (new_client_fd <= 0) {
-                    return SERVER_FAILED_ACCEPT_TCP;
-                } else {
-                    if ((err = poll_vec_add_fd(
-                        this->poll_vec,
-                        new_client_fd,
-                        POLLIN | POLLOUT)) != OK
-                    ) {
-                        return err;
-                    }
+        /* A queued frame holds its own reference */
+        tcp_frame_release(&client->ready_msgs[sent_msgs]);
+        err = OK;
+    }
 
-                    /* Receive the client's ID */
-                    if ((err = recv_tcp_msg(
-                        new_client_fd,
-                        (void *)this->recv_msg,
-                        sizeof *this->recv_msg)) != OK
-                    ) {
-                        return SERVER_COULD_NOT_CONNECT_NEW_CLIENT;
-                    } else {
-                        if ((err = register_new_client(
-                            this->clients,
-                            this->recv_msg->data,
-                            new_client_fd)) != OK
-                        ) {
-                            /* Client is already connected with the specified ID */
-
-                            poll_vec_remove_fd(this->poll_vec, this->poll_vec->nfds - 1);
-                            printf("Client %s already connected.\n", this->recv_msg->data);
-                        } else {
-                            /* New client arrived or a dead client is reconnected */
-
-                            printf(
-                                "New client %s connected from %s:%hu.\n",
-                                this->recv_msg->data,
-                                inet_ntoa(new_client.sin_addr),
-                                ntohs(new_client.sin_port)
-                            );
-
-                            /* If the client is reconnecting retransmit the topic messages */
-                            if ((err = retransmit_topics_to_client(this, new_client_fd)) != OK) {
-                                debug_msg(err);
-                            }
-                        }
-                    }
-                }
-            } else {
-                /* Process a client TCP message */
-
-                if ((err = recv_tcp_msg(
-                    this->poll_vec->pfds[iter].fd,
-                    (void *)this->recv_msg,
-                    sizeof *this->recv_msg)) != OK
-                ) {
-                    /*
-                     * Could not receive the message,
-                     * it means the client has closed the connection
-                     * so change the status of the client
-                     */
-
-                    size_t close_client_idx = 0;
-                    if ((err = close_active_client(
-                        this->clients,
-                        this->poll_vec->pfds[iter].fd,
-                        &close_client_idx)) != OK
-                    ) {
-                        debug_msg(err);
-                    } else {
-                        poll_vec_remove_fd(this->poll_vec, iter);
-                        iter--;
-
-                        printf(
-                            "Client %s disconnected.\n",
-                            get_client_id(this->clients,
-                            close_client_idx)
-                        );
-                    }
-                } else {
-                    /* Message received successfully, process it */
-
-                    if ((err = process_server_tcp_msg(
-                        this,
-                        this->poll_vec->pfds[iter].fd)) != OK
-                    ) {
-                        debug_msg(err);
-                    }
-                }
-            }
+    /* Keep the messages that did not fit for the next POLLOUT */
+    memmove(
+        client->ready_msgs,
+        client->ready_msgs + sent_msgs,
+        sizeof *client->ready_msgs * (client->ready_msgs_len - sent_msgs)
+    );
+
+    client->ready_msgs_len -= sent_msgs;
+
+    if ((sent_msgs > 0) && (this->journal != NULL)) {
+        err_t journal_err = journal_consume(this->journal, client->idx, sent_msgs);
+
+        if (journal_err != OK) {
+            debug_msg(journal_err);
         }
     }
 
-    return OK;
+    return err == TCP_WRITER_FULL ? OK : err;
 }
 
 /**
- * @brief Receives an input command from the stdin and processes it
- * by checking if the command is exit.
+ * @brief Sends the outbound queue of a client on POLLOUT, when the
+ * queue is empty the stacked messages are queued and the client
+ * stops being watched for POLLOUT.
  *
  * @param this server structure.
- * @return uint8_t 1 if command is exit or 0 otherwise.
+ * @param client active client record.
+ * @return err_t OK if the queue was flushed or error otherwise.
  */
-uint8_t check_if_exit(server_t *this) {
-    if (this == NULL) {
-        return SERVER_INPUT_IS_NULL;
-    }
+static err_t flush_client_queue(server_t *this, client_type_t *client) {
+    err_t err = OK;
 
-    if (this->cmd == NULL) {
-        return CMD_INPUT_IS_NULL;
-    }
+    this->queue_stats.pollout_wakeups++;
 
-    if (this->poll_vec == NULL) {
-        return POLL_VEC_INPUT_IS_NULL;
+    if ((err = tcp_writer_flush(client->fd, &client->writer)) != OK) {
+        return err == TCP_WOULD_BLOCK ? OK : err;
     }
 
-    if (this->poll_vec->pfds[0].fd == STDIN_FILENO) {
-        if ((this->poll_vec->pfds[0].revents & POLLIN) != 0) {
-            if (fgets(this->cmd, MAX_CMD_LEN, stdin) != NULL) {
-                return (uint8_t)(strncmp(this->cmd, EXIT_CMD, EXIT_CMD_LEN) == 0);
-            }
-        }
+    if ((err = refill_client_queue(this, client)) != OK) {
+        return err;
     }
 
-    return 0;
+    return watch_client_queue(this, client);
+}
+
+/**
+ * @brief Stacks a shared frame in the store-and-forward backlog
+ * of a client, the client is added to the recipients of the
+ * next journal frame record.
+ *
+ * @param this server structure.
+ * @param frame shared frame of the udp message.
+ * @param client_idx valid client index.
+ * @return err_t OK if the message was stacked or error otherwise.
+ */
+static err_t stack_topic_for_client(server_t *this, tcp_frame_t *frame, size_t client_idx) {
+    err_t err = OK;
+
+    if ((err = add_topic_msg_for_client(this->clients, frame, client_idx)) != OK) {
+        return err;
+    }
+
+    if (this->journal != NULL) {
+        return journal_add_recipient(this->journal, client_idx);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Sends a shared frame to an active client without blocking.
+ * If the outbound queue of the client is full the configured overflow
+ * policy is applied.
+ *
+ * @param this server structure.
+ * @param frame shared frame of the udp message.
+ * @param client_idx index of an active client.
+ * @return err_t OK if the message was sent, queued or handled by the
+ * overflow policy or error otherwise.
+ */
+static err_t send_topic_to_client(server_t *this, tcp_frame_t *frame, size_t client_idx) {
+    err_t err = OK;
+    client_type_t *client = this->clients->entities[client_idx];
+
+    /* The stacked messages are older, keep the order behind them */
+    if (client->ready_msgs_len > 0) {
+        this->queue_stats.spilled_msgs++;
+
+        return stack_topic_for_client(this, frame, client_idx);
+    }
+
+    err = tcp_writer_send(client->fd, &client->writer, frame);
+
+    if (err == TCP_WRITER_FULL) {
+        switch (this->config.overflow) {
+            case OVERFLOW_DROP_OLDEST:
+                while ((err == TCP_WRITER_FULL) && (tcp_writer_drop_oldest(&client->writer) == OK)) {
+                    this->queue_stats.dropped_frames++;
+
+                    err = tcp_writer_send(client->fd, &client->writer, frame);
+                }
+
+                if (err == TCP_WRITER_FULL) {
+                    /* Just a partial frame is queued, drop the new one */
+
+                    this->queue_stats.dropped_frames++;
+
+                    return OK;
+                }
+                break;
+            case OVERFLOW_DISCONNECT:
+                this->queue_stats.overflow_disconnects++;
+                disconnect_client(this, client);
+
+                return OK;
+            default:
+                this->queue_stats.spilled_msgs++;
+
+                return stack_topic_for_client(this, frame, client_idx);
+        }
+    }
+
+    if (err == TCP_WOULD_BLOCK) {
+        this->queue_stats.queued_frames++;
+
+        return watch_client_queue(this, client);
+    }
+
+    if (err != OK) {
+        /* The connection is closed */
+
+        disconnect_client(this, client);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Sends a new topic message to all subscribed clients.
+ * If one client is disconnected, but has the store-and-forward
+ * functionality the a reference to the message will be stacked
+ * in a local client queue and upon reconnection the message will be sent.
+ *
+ * The message is serialized once into a shared frame, every outbound
+ * queue and backlog holding the frame takes its own reference.
+ *
+ * The subscribers are fetched from the topic index, so just the
+ * clients subscribed to the topic are visited.
+ *
+ * The backlogs that got the message are appended to the journal.
+ *
+ * @param this server structure.
+ * @param seq sequence number of the message.
+ * @param record udp message record retained by the message store.
+ * @return err_t OK if the udp message was sent to all active clients or
+ * error otherwise.
+ */
+static err_t transmit_topic_to_clients(server_t *this, uint64_t seq, udp_record_t *record) {
+    err_t err = OK;
+
+    /* Topic without any subscribers */
+    topic_entry_t *topic = &this->clients->topic_table->entries[record->topic_id];
+    if (topic->subs_len == 0) {
+        return OK;
+    }
+
+    /* Get the message ready for shipping */
+    if ((err = pack_topic_to_tcp_msg(this, record))) {
+        return err;
+    }
+
+    tcp_frame_t *frame = NULL;
+    if ((err = create_tcp_frame(&frame, this->send_msg)) != OK) {
+        return err;
+    }
+
+    frame->seq = seq;
+
+    /* Iterate over the active/dead subscribers of the topic */
+    for (uint32_t iter = 0; iter < topic->subs_len; ++iter) {
+        client_type_t *client = this->clients->entities[topic->subs[iter].client_idx];
+
+        if (client->status == ACTIVE) {
+            /* Client is active, send or queue the package */
+
+            if ((err = send_topic_to_client(
+                this,
+                frame,
+                topic->subs[iter].client_idx)) != OK
+            ) {
+                debug_msg(err);
+                err = OK;
+            }
+        } else if (topic->subs[iter].sf == SF) {
+            /* Client is dead, however has the store-and-forward option */
+
+            if ((err = stack_topic_for_client(
+                this,
+                frame,
+                topic->subs[iter].client_idx)) != OK
+            ) {
+                break;
+            }
+        }
+    }
+
+    /* Persist the message for the backlogs that got it */
+    if (this->journal != NULL) {
+        err_t journal_err = journal_frame(this->journal, frame);
+
+        if (journal_err != OK) {
+            debug_msg(journal_err);
+        }
+    }
+
+    /* The subscribers keep their own references */
+    tcp_frame_release(&frame);
+
+    return err;
+}
+
+/**
+ * @brief Hands the parsed messages starting with first_seq to the
+ * fan-out, then the oldest messages of the store can expire.
+ *
+ * @param this server structure.
+ * @param first_seq sequence number of the first parsed message.
+ * @return err_t OK if the messages were sent or error otherwise.
+ */
+static err_t transmit_parsed_udp_msgs(server_t *this, uint64_t first_seq) {
+    err_t err = OK;
+
+    for (uint64_t seq = first_seq; seq < msg_store_next_seq(this->msg_store); ++seq) {
+        udp_record_t *record = NULL;
+
+        if ((msg_store_get(this->msg_store, seq, &record) == OK) &&
+            ((err = transmit_topic_to_clients(this, seq, record)) != OK)) {
+            return err;
+        }
+    }
+
+    /* The batch is sent, the oldest messages can expire */
+    msg_store_expire(this->msg_store);
+
+    return OK;
+}
+
+/**
+ * @brief Drains the UDP socket with batched recvmmsg calls. Every batch
+ * is parsed into the local storage first and then the whole batch is
+ * handed to the fan-out. The socket is drained until it has no datagrams
+ * left or the drain limit is reached, so the TCP clients are not starved.
+ *
+ * @param this server structure.
+ * @return err_t OK if the datagrams were processed or error otherwise.
+ */
+static err_t ingest_udp_datagrams(server_t *this) {
+    err_t err = OK;
+    udp_batch_t *batch = this->udp_batch;
+    size_t drained = 0;
+
+    while (drained < this->config.udp_drain_limit) {
+        size_t nmsgs = 0;
+
+        if ((err = udp_batch_recv(
+            batch,
+            this->udp_socket,
+            this->config.udp_drain_limit - drained,
+            &nmsgs)) != OK
+        ) {
+            return err;
+        }
+
+        if (nmsgs == 0) {
+            break;
+        }
+
+        /* Parse the whole batch, malformed datagrams are dropped */
+        uint64_t first_seq = msg_store_next_seq(this->msg_store);
+
+        for (size_t iter = 0; iter < nmsgs; ++iter) {
+            if ((batch->msgs[iter].msg_len == 0) ||
+                ((err = add_server_udp_msg(
+                    this,
+                    udp_batch_buf(batch, iter),
+                    &batch->addrs[iter])) != OK)
+            ) {
+                if (err == SERVER_COULD_NOT_ADD_NEW_UDP) {
+                    return err;
+                }
+
+                batch->stats.parse_errors++;
+                err = OK;
+            }
+        }
+
+        /* Hand the parsed batch to the fan-out */
+        if ((err = transmit_parsed_udp_msgs(this, first_seq)) != OK) {
+            return err;
+        }
+
+        drained += nmsgs;
+
+        /* A partial batch means the socket has no datagrams left */
+        if (nmsgs < batch->len) {
+            break;
+        }
+    }
+
+    if (drained >= this->config.udp_drain_limit) {
+        batch->stats.drain_limit_hits++;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Upon reconnecting with a client the stacked messages will
+ * be queued for the client in the order they were stacked. The
+ * messages that do not fit in the outbound queue are queued on the
+ * next POLLOUT events. If the client closes its connection the
+ * rest of the messages wait for another reconnection.
+ *
+ * @param this server structure.
+ * @param client reconnected client record.
+ * @return err_t OK if the udp messages were queued for the client
+ * or error otherwise.
+ */
+static err_t retransmit_topics_to_client(server_t *this, client_type_t *client) {
+    err_t err = OK;
+
+    if (client->ready_msgs_len == 0) {
+        return OK;
+    }
+
+    if ((err = refill_client_queue(this, client)) != OK) {
+        return err;
+    }
+
+    return watch_client_queue(this, client);
+}
+
+/**
+ * @brief Registers a client that completed its handshake, a new client
+ * is added and a dead client is reconnected with its stacked messages.
+ *
+ * @param this server structure.
+ * @param fd socket of the client.
+ * @param proto wire format of the client.
+ * @param id ID of the client.
+ * @param addr address of the client.
+ * @return err_t OK if the client was handled or error otherwise.
+ */
+static err_t connect_client(server_t *this, int fd, tcp_proto_t proto, char *id,
+    const struct sockaddr_in *addr) {
+    err_t err = OK;
+    size_t client_idx = 0;
+    size_t registered_clients = this->clients->len;
+    char ip[INET_ADDRSTRLEN];
+
+    /* The client record is linked to the fd after registration */
+    if ((err = poll_vec_add_fd_data(this->poll_vec, fd, POLLIN, NULL)) != OK) {
+        close(fd);
+        return err;
+    }
+
+    if (register_new_client(this->clients, id, fd, proto, &client_idx) != OK) {
+        /* Client is already connected with the specified ID */
+
+        poll_vec_remove_fd_by(this->poll_vec, fd);
+        printf("Client %s already connected.\n", id);
+
+        return OK;
+    }
+
+    /* New client arrived or a dead client is reconnected */
+    client_type_t *client = this->clients->entities[client_idx];
+
+    if ((this->journal != NULL) && (this->clients->len > registered_clients) &&
+        ((err = journal_client(this->journal, client->id)) != OK)) {
+        debug_msg(err);
+    }
+
+    poll_vec_set_fd_data(this->poll_vec, fd, client);
+
+    /* The client is never waited for after the handshake */
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    /* The io_uring backend sends the queue after every wakeup */
+    client->writer.async = (uint8_t)(this->poll_vec->backend == URING_BACKEND);
+
+    inet_ntop(AF_INET, &addr->sin_addr, ip, sizeof ip);
+    printf("New client %s connected from %s:%hu.\n", id, ip, ntohs(addr->sin_port));
+
+    /* If the client is reconnecting retransmit the topic messages */
+    if ((err = retransmit_topics_to_client(this, client)) != OK) {
+        debug_msg(err);
+        disconnect_client(this, client);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Receives the client's ID of an accepted connection. In a
+ * server pool the client is handed off to the worker shard that owns
+ * its ID, so a reconnecting client finds its subscriptions and its
+ * stacked messages.
+ *
+ * @param this server structure.
+ * @param fd socket of the accepted connection.
+ * @param addr address of the client.
+ * @return err_t OK if the connection was handled or error otherwise.
+ */
+static err_t handshake_client(server_t *this, int fd, const struct sockaddr_in *addr) {
+    err_t err = OK;
+
+    /* Receive the client's ID and detect its wire format */
+    tcp_proto_t proto = TCP_PROTO_LEGACY;
+    if ((err = recv_tcp_handshake(fd, this->recv_msg, &proto)) != OK) {
+        /* Wrong handshake drops just this connection */
+
+        debug_msg(err);
+        close(fd);
+
+        return OK;
+    }
+
+    if (this->pool != NULL) {
+        size_t owner = this->shard_id;
+
+        if ((err = server_pool_claim_client(this->pool, this->recv_msg->data, this->shard_id, &owner)) != OK) {
+            close(fd);
+
+            return err;
+        }
+
+        if (owner != this->shard_id) {
+            if ((err = server_pool_handoff_client(this->pool, owner, fd, proto, this->recv_msg->data, addr)) != OK) {
+                debug_msg(err);
+                close(fd);
+            }
+
+            return OK;
+        }
+    }
+
+    return connect_client(this, fd, proto, this->recv_msg->data, addr);
+}
+
+/**
+ * @brief Accepts a new connection and receives the client's ID.
+ *
+ * @param this server structure.
+ * @return err_t OK if the connection was handled or error otherwise.
+ */
+static err_t accept_client(server_t *this) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+
+    int fd = accept(this->tcp_socket, (struct sockaddr *) &addr, &(socklen_t){sizeof addr});
+
+    if (fd <= 0) {
+        return SERVER_FAILED_ACCEPT_TCP;
+    }
+
+    return handshake_client(this, fd, &addr);
+}
+
+/**
+ * @brief Checks if a failed io_uring operation cannot be started again,
+ * the other errors are transient and the operation is restarted.
+ *
+ * @param res negative errno result of the operation.
+ * @return uint8_t 1 if the operation is not supported or 0 otherwise.
+ */
+static uint8_t is_uring_op_unsupported(int32_t res) {
+    return (uint8_t)((res == -EINVAL) || (res == -EBADF) || (res == -ENOTSOCK) || (res == -EOPNOTSUPP));
+}
+
+/**
+ * @brief Handles a connection accepted by the multishot accept of the
+ * io_uring backend, the accept is started again when the kernel ends it.
+ *
+ * @param this server structure.
+ * @param event completion of the accept.
+ * @return err_t OK if the connection was handled or error otherwise.
+ */
+static err_t accept_uring_client(server_t *this, poll_vec_event_t *event) {
+    err_t err = OK;
+
+    if (event->res >= 0) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof addr);
+
+        getpeername(event->res, (struct sockaddr *) &addr, &(socklen_t){sizeof addr});
+
+        if ((err = handshake_client(this, event->res, &addr)) != OK) {
+            return err;
+        }
+    } else if (is_uring_op_unsupported(event->res)) {
+        return SERVER_FAILED_ACCEPT_TCP;
+    }
+
+    if ((event->flags & IORING_CQE_F_MORE) == 0) {
+        return poll_vec_accept(this->poll_vec, this->tcp_socket);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Parses a datagram received by the multishot receive of the
+ * io_uring backend into the message store and gives its provided buffer
+ * back to the kernel. The receive is started again when the kernel ends
+ * it, for example when it runs out of provided buffers.
+ *
+ * @param this server structure.
+ * @param event completion of the receive.
+ * @return err_t OK if the datagram was handled or error otherwise.
+ */
+static err_t ingest_uring_datagram(server_t *this, poll_vec_event_t *event) {
+    err_t err = OK;
+    udp_batch_stats_t *stats = &this->udp_batch->stats;
+
+    if ((event->flags & IORING_CQE_F_BUFFER) != 0) {
+        uint16_t bid = (uint16_t)(event->flags >> IORING_CQE_BUFFER_SHIFT);
+        uint8_t *buf = uring_buf(this->poll_vec->uring, bid);
+        struct io_uring_recvmsg_out *out = (struct io_uring_recvmsg_out *)buf;
+        char *payload = (char *)buf + sizeof *out + sizeof (struct sockaddr_in);
+        size_t len = (size_t)event->res - sizeof *out - sizeof (struct sockaddr_in);
+
+        memset(payload + len, 0, UDP_SLOT_LEN - len);
+
+        if ((out->payloadlen == 0) || ((out->flags & MSG_TRUNC) != 0) ||
+            ((err = add_server_udp_msg(
+                this,
+                payload,
+                (struct sockaddr_in *)(buf + sizeof *out))) != OK)
+        ) {
+            stats->parse_errors++;
+        }
+
+        uring_release_buf(this->poll_vec->uring, bid);
+
+        if (err == SERVER_COULD_NOT_ADD_NEW_UDP) {
+            return err;
+        }
+    } else if (event->res == -ENOBUFS) {
+        this->poll_vec->uring->stats.bufs_exhausted++;
+    } else if (is_uring_op_unsupported(event->res)) {
+        return SERVER_FAILED_UDP;
+    }
+
+    if ((event->flags & IORING_CQE_F_MORE) == 0) {
+        return poll_vec_recvmsg(this->poll_vec, this->udp_socket, &this->udp_hdr);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Consumes the frames taken by a send of the io_uring backend,
+ * when the queue is empty the stacked messages are queued.
+ *
+ * @param this server structure.
+ * @param client active client record.
+ * @param res result of the send.
+ * @return err_t OK if the send was completed or error otherwise.
+ */
+static err_t complete_client_send(server_t *this, client_type_t *client, int32_t res) {
+    err_t err = OK;
+
+    if (res < 0) {
+        return TCP_FAILED_SEND_RECV;
+    }
+
+    tcp_writer_complete(&client->writer, (size_t)res);
+
+    if ((client->writer.len == 0) && ((err = refill_client_queue(this, client)) != OK)) {
+        return err;
+    }
+
+    return watch_client_queue(this, client);
+}
+
+/**
+ * @brief Starts one gathered send for every client with queued frames
+ * and no send in flight, the sends are submitted with the next wait.
+ *
+ * @param this server structure.
+ */
+static void submit_client_sends(server_t *this) {
+    for (size_t iter = 0; iter < this->send_list_len; ++iter) {
+        client_type_t *client = this->send_list[iter];
+        struct msghdr *hdr = NULL;
+
+        client->send_listed = 0;
+
+        if ((client->status == DEAD) || (tcp_writer_prepare(&client->writer, &hdr) != OK)) {
+            continue;
+        }
+
+        if (poll_vec_sendmsg(this->poll_vec, client->fd, hdr) != OK) {
+            disconnect_client(this, client);
+            continue;
+        }
+    }
+
+    this->send_list_len = 0;
+}
+
+/**
+ * @brief Records a chunk of udp records taken from the ring of a
+ * worker shard or received by the io_uring backend in the udp counters.
+ *
+ * @param this server structure.
+ * @param datagrams number of records in the chunk.
+ */
+static void count_udp_batch(server_t *this, uint64_t datagrams) {
+    udp_batch_stats_t *stats = &this->udp_batch->stats;
+
+    if (datagrams == 0) {
+        return;
+    }
+
+    stats->batches++;
+    stats->datagrams += datagrams;
+    stats->last_batch = datagrams;
+
+    if (datagrams > stats->max_batch) {
+        stats->max_batch = datagrams;
+    }
+
+    if (datagrams == this->udp_batch->len) {
+        stats->full_batches++;
+    }
+}
+
+/**
+ * @brief Processes the records in the ring of a worker shard, the
+ * records are copied in the message store and handed to the fan-out
+ * in chunks of udp batch length.
+ *
+ * @param this server structure.
+ * @return err_t OK if the records were processed or error otherwise.
+ */
+static err_t process_shard_ring(server_t *this) {
+    err_t err = OK;
+    uint8_t *data = NULL;
+    size_t len = 0;
+    uint64_t datagrams = 0;
+    uint64_t first_seq = msg_store_next_seq(this->msg_store);
+
+    spsc_ring_ack(this->ring);
+
+    while (spsc_ring_next(this->ring, &data, &len) == OK) {
+        udp_record_t *record = (udp_record_t *)data;
+
+        if ((err = add_server_udp_record(this, record, (char *)data + udp_record_size(record))) != OK) {
+            return err;
+        }
+
+        if (++datagrams == this->udp_batch->len) {
+            if ((err = transmit_parsed_udp_msgs(this, first_seq)) != OK) {
+                return err;
+            }
+
+            count_udp_batch(this, datagrams);
+
+            datagrams = 0;
+            first_seq = msg_store_next_seq(this->msg_store);
+        }
+    }
+
+    if ((err = transmit_parsed_udp_msgs(this, first_seq)) != OK) {
+        return err;
+    }
+
+    count_udp_batch(this, datagrams);
+
+    return OK;
+}
+
+/**
+ * @brief Processes the control messages posted to the inbox
+ * of a worker shard in the order they were posted.
+ *
+ * @param this server structure.
+ * @return err_t OK if the messages were processed or error otherwise.
+ */
+static err_t process_shard_inbox(server_t *this) {
+    err_t err = OK;
+    uint8_t *buf = NULL;
+    size_t len = 0;
+
+    if ((err = shard_inbox_take(this->inbox, &buf, &len)) != OK) {
+        return err;
+    }
+
+    for (size_t offset = 0; offset < len;) {
+        shard_msg_t *msg = (shard_msg_t *)(buf + offset);
+
+        offset += msg->size;
+
+        switch (msg->type) {
+            case SHARD_MSG_CLIENT:
+                if ((err = connect_client(this, msg->fd, (tcp_proto_t)msg->proto, msg->data, &msg->addr)) != OK) {
+                    return err;
+                }
+                break;
+            case SHARD_MSG_STATS:
+                print_server_stats(this);
+                break;
+            case SHARD_MSG_EXIT:
+                this->stopped = 1;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Receives a message from the client and processes it.
+ * The stdin fd is NOT processed here.
+ * Message can be processed both from udp and tcp sockets, if
+ * the ready socket is udp then the message will be processed and a POLLOUT
+ * will be generated for the clients subscribed at the desired topic.
+ * The udp message is saved internally in case a new client subscribes to the topic,
+ * ot the udp message was not send due to closed connection (SF functionality).
+ *
+ * In case of a TCP POLLIN the server will process the message without sending
+ * any messages back.
+ *
+ * With the io_uring backend the completions are handled by their operation,
+ * the datagrams of the wakeup are handed to the fan-out together and the
+ * queued frames are sent with one gathered send per client.
+ *
+ * The journal records appended during the wakeup are flushed at the end,
+ * at most once every journal sync delay.
+ *
+ * @param this server structure.
+ * @return err_t OK if the messages were processed successfully or error otherwise.
+ */
+err_t process_ready_fds(server_t *this) {
+    if (this == NULL) {
+        return SERVER_INPUT_IS_NULL;
+    }
+
+    if (this->poll_vec == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    err_t err = OK;
+    uint64_t first_seq = msg_store_next_seq(this->msg_store);
+    uint64_t datagrams = 0;
+
+    /* Visit just the fds reported as ready by the poll vector */
+    for (nfds_t iter = 0; iter < this->poll_vec->nready; ++iter) {
+        poll_vec_event_t *event = &this->poll_vec->ready[iter];
+
+        if ((event->fd < 0) || (event->fd == STDIN_FILENO)) {
+            /* Removed during this wakeup or processed by check_if_exit */
+
+            continue;
+        }
+
+        if (event->op == POLL_VEC_OP_ACCEPT) {
+            if ((err = accept_uring_client(this, event)) != OK) {
+                return err;
+            }
+
+            continue;
+        }
+
+        if (event->op == POLL_VEC_OP_RECVMSG) {
+            if ((err = ingest_uring_datagram(this, event)) != OK) {
+                return err;
+            }
+
+            datagrams += (uint64_t)(event->res >= 0);
+            continue;
+        }
+
+        if (event->op == POLL_VEC_OP_SENDMSG) {
+            client_type_t *client = event->data;
+
+            if ((client != NULL) && (complete_client_send(this, client, event->res) != OK)) {
+                disconnect_client(this, client);
+            }
+
+            continue;
+        }
+
+        if ((event->revents & (POLLIN | POLLOUT | POLLHUP | POLLERR)) == 0) {
+            continue;
+        }
+
+        if (event->fd == this->udp_socket) {
+            /* Process a batch of UDP messages */
+
+            if ((err = ingest_udp_datagrams(this)) != OK) {
+                return err;
+            }
+        } else if (event->fd == this->tcp_socket) {
+            /* Connect a new client to the server */
+
+            if ((err = accept_client(this)) != OK) {
+                return err;
+            }
+        } else if (event->fd == this->ring_fd) {
+            /* Send the udp records routed to the worker shard */
+
+            if ((err = process_shard_ring(this)) != OK) {
+                return err;
+            }
+        } else if (event->fd == this->inbox_fd) {
+            /* Process the control messages posted to the worker shard */
+
+            if ((err = process_shard_inbox(this)) != OK) {
+                return err;
+            }
+        } else {
+            /* Process the client TCP frames */
+
+            client_type_t *client = event->data;
+
+            if (client == NULL) {
+                poll_vec_remove_fd_by(this->poll_vec, event->fd);
+                continue;
+            }
+
+            /* The socket can take the queued frames */
+            if ((event->revents & POLLOUT) != 0) {
+                if (flush_client_queue(this, client) != OK) {
+                    disconnect_client(this, client);
+                    continue;
+                }
+            }
+
+            if ((event->revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+
+            /* Read what is available and process every complete frame */
+            err_t read_err = tcp_reader_fill(event->fd, &client->reader);
+
+            while ((read_err == OK) && ((err = tcp_reader_next(&client->reader, this->recv_msg)) == OK)) {
+                if ((err = process_server_tcp_msg(this, client)) != OK) {
+                    debug_msg(err);
+                }
+            }
+
+            if ((read_err == OK) && (err == TCP_INVALID_FRAME)) {
+                read_err = err;
+            }
+
+            if ((read_err != OK) && (read_err != TCP_WOULD_BLOCK)) {
+                /*
+                 * Could not receive the message,
+                 * it means the client has closed the connection
+                 * so change the status of the client
+                 */
+
+                disconnect_client(this, client);
+            }
+        }
+    }
+
+    /* Hand the datagrams received by the io_uring backend to the fan-out */
+    if (datagrams > 0) {
+        if ((err = transmit_parsed_udp_msgs(this, first_seq)) != OK) {
+            return err;
+        }
+
+        count_udp_batch(this, datagrams);
+    }
+
+    submit_client_sends(this);
+
+    /* The records of this wakeup are flushed in one group */
+    if ((this->journal != NULL) && ((err = journal_sync(this->journal, 0)) != OK)) {
+        debug_msg(err);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Receives an input command from the stdin and processes it
+ * by checking if the command is exit. The stats command prints the
+ * server counters.
+ *
+ * @param this server structure.
+ * @return uint8_t 1 if command is exit or 0 otherwise.
+ */
+uint8_t check_if_exit(server_t *this) {
+    if (this == NULL) {
+        return SERVER_INPUT_IS_NULL;
+    }
+
+    if (this->cmd == NULL) {
+        return CMD_INPUT_IS_NULL;
+    }
+
+    if (this->poll_vec == NULL) {
+        return POLL_VEC_INPUT_IS_NULL;
+    }
+
+    for (nfds_t iter = 0; iter < this->poll_vec->nready; ++iter) {
+        if (this->poll_vec->ready[iter].fd == STDIN_FILENO) {
+            if ((this->poll_vec->ready[iter].revents & POLLIN) != 0) {
+                if (fgets(this->cmd, MAX_CMD_LEN, stdin) != NULL) {
+                    if (strncmp(this->cmd, STATS_CMD, STATS_CMD_LEN) == 0) {
+                        print_server_stats(this);
+                        return 0;
+                    }
+
+                    return (uint8_t)(strncmp(this->cmd, EXIT_CMD, EXIT_CMD_LEN) == 0);
+                }
+            }
+
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Prints the server counters on the stdout. The counters of
+ * a worker shard are printed in one block after a worker line.
+ *
+ * @param this server structure.
+ */
+void print_server_stats(server_t *this) {
+    if (this == NULL) {
+        return;
+    }
+
+    udp_batch_stats_t *udp = &this->udp_batch->stats;
+    queue_stats_t *queue = &this->queue_stats;
+    msg_store_t *store = this->msg_store;
+
+    flockfile(stdout);
+
+    if (this->ring != NULL) {
+        printf(
+            "worker %zu: clients %zu, busy %.1f%%, ring depth %zu, max depth %" PRIu64
+            ", capacity %zu, records %" PRIu64 ", ring batches %" PRIu64 ".\n",
+            this->shard_id, this->clients->len, stage_busy_percent(&this->stage),
+            spsc_ring_depth(this->ring), this->ring->max_depth, this->ring->capacity,
+            this->ring->entries, this->ring->batches
+        );
+    }
+
+    printf(
+        "udp: datagrams %" PRIu64 ", batches %" PRIu64 ", last batch %" PRIu64
+        ", max batch %" PRIu64 ", full batches %" PRIu64 ", drain limit hits %" PRIu64
+        ", parse errors %" PRIu64 ".\n",
+        udp->datagrams, udp->batches, udp->last_batch, udp->max_batch,
+        udp->full_batches, udp->drain_limit_hits, udp->parse_errors
+    );
+
+    printf(
+        "queues: queued frames %" PRIu64 ", pollout wakeups %" PRIu64 ", max queued bytes %" PRIu64
+        ", dropped frames %" PRIu64 ", spilled messages %" PRIu64 ", overflow disconnects %" PRIu64 ".\n",
+        queue->queued_frames, queue->pollout_wakeups, queue->max_queued_bytes,
+        queue->dropped_frames, queue->spilled_msgs, queue->overflow_disconnects
+    );
+
+    printf(
+        "store: retained messages %zu, record bytes %" PRIu64 ", segments %zu, free segments %zu"
+        ", appended %" PRIu64 ", expired %" PRIu64 ", segments allocated %" PRIu64
+        ", segments recycled %" PRIu64 ".\n",
+        store->len, store->stats.record_bytes, store->seg_len, store->free_len, store->stats.appended,
+        store->stats.expired, store->stats.segments_allocated, store->stats.segments_recycled
+    );
+
+    if (this->poll_vec->uring != NULL) {
+        uring_stats_t *uring = &this->poll_vec->uring->stats;
+
+        printf(
+            "uring: enters %" PRIu64 ", sqes %" PRIu64 ", cqes %" PRIu64 ", buffer stops %" PRIu64 ".\n",
+            uring->enters, uring->sqes, uring->cqes, uring->bufs_exhausted
+        );
+    }
+
+    if (this->journal != NULL) {
+        journal_stats_t *journal = &this->journal->stats;
+
+        printf(
+            "journal: records %" PRIu64 ", bytes %" PRIu64 ", syncs %" PRIu64
+            ", replayed records %" PRIu64 ", replayed messages %" PRIu64 ".\n",
+            journal->records, journal->bytes, journal->syncs,
+            journal->replayed_records, journal->replayed_frames
+        );
+    }
+
+    funlockfile(stdout);
 }
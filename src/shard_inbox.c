@@ -0,0 +1,231 @@
+/**
+ * @file shard_inbox.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/shard_inbox.h"
+
+/**
+ * @brief Creates an empty shard inbox.
+ *
+ * @param inbox pointer to inbox structure to allocate, must be NULL.
+ * @param limit max bytes of the posted messages.
+ * @return err_t OK if the inbox was allocated or error otherwise.
+ */
+err_t create_shard_inbox(shard_inbox_t **inbox, size_t limit) {
+    if ((inbox == NULL) || (*inbox != NULL)) {
+        return SHARD_INBOX_INPUT_IS_NOT_NULL;
+    }
+
+    *inbox = calloc(1, sizeof **inbox);
+    if (*inbox == NULL) {
+        return SHARD_INBOX_FAILED_ALLOCATION;
+    }
+
+    (*inbox)->limit = limit;
+    (*inbox)->capacity = INIT_SHARD_INBOX_LEN;
+    (*inbox)->spare_capacity = INIT_SHARD_INBOX_LEN;
+    (*inbox)->buf = malloc((*inbox)->capacity);
+    (*inbox)->spare = malloc((*inbox)->spare_capacity);
+    (*inbox)->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (((*inbox)->buf == NULL) || ((*inbox)->spare == NULL) || ((*inbox)->event_fd < 0)) {
+        if ((*inbox)->event_fd >= 0) {
+            close((*inbox)->event_fd);
+        }
+
+        free((*inbox)->buf);
+        free((*inbox)->spare);
+        free(*inbox);
+        *inbox = NULL;
+
+        return SHARD_INBOX_FAILED_ALLOCATION;
+    }
+
+    pthread_mutex_init(&(*inbox)->lock, NULL);
+
+    return OK;
+}
+
+/**
+ * @brief Frees a shard inbox and sets it to NULL, the
+ * posted messages are dropped.
+ *
+ * @param inbox pointer to inbox structure.
+ * @return err_t OK if the inbox was freed or error otherwise.
+ */
+err_t free_shard_inbox(shard_inbox_t **inbox) {
+    if ((inbox == NULL) || (*inbox == NULL)) {
+        return SHARD_INBOX_INPUT_IS_NULL;
+    }
+
+    pthread_mutex_destroy(&(*inbox)->lock);
+    close((*inbox)->event_fd);
+
+    free((*inbox)->buf);
+    free((*inbox)->spare);
+    free(*inbox);
+    *inbox = NULL;
+
+    return OK;
+}
+
+/**
+ * @brief Locks the inbox in order to append a group of messages.
+ *
+ * @param inbox inbox structure.
+ */
+void shard_inbox_lock(shard_inbox_t *inbox) {
+    pthread_mutex_lock(&inbox->lock);
+
+    inbox->signal = (uint8_t)(inbox->len == 0);
+}
+
+/**
+ * @brief Appends a message to a locked inbox.
+ *
+ * @param inbox locked inbox structure.
+ * @param msg header of the message, the size and len fields are set.
+ * @param data data bytes of the message or NULL.
+ * @param len number of data bytes.
+ * @return err_t OK if the message was appended or SHARD_INBOX_FULL otherwise.
+ */
+err_t shard_inbox_append(shard_inbox_t *inbox, const shard_msg_t *msg, const void *data, size_t len) {
+    size_t size = (sizeof (shard_msg_t) + len + SHARD_MSG_ALIGN - 1) & ~(SHARD_MSG_ALIGN - 1);
+
+    if ((len > UINT16_MAX) || (inbox->len + size > inbox->limit)) {
+        inbox->dropped++;
+
+        return SHARD_INBOX_FULL;
+    }
+
+    if (inbox->len + size > inbox->capacity) {
+        size_t capacity = inbox->capacity;
+
+        while (inbox->len + size > capacity) {
+            capacity *= REALLOC_FACTOR;
+        }
+
+        uint8_t *buf_real = realloc(inbox->buf, capacity);
+        if (buf_real == NULL) {
+            inbox->dropped++;
+
+            return SHARD_INBOX_FULL;
+        }
+
+        inbox->buf = buf_real;
+        inbox->capacity = capacity;
+    }
+
+    shard_msg_t *posted = (shard_msg_t *)(inbox->buf + inbox->len);
+
+    *posted = *msg;
+    posted->size = (uint32_t)size;
+    posted->len = (uint16_t)len;
+
+    if (len > 0) {
+        memcpy(posted->data, data, len);
+    }
+
+    inbox->len += size;
+
+    return OK;
+}
+
+/**
+ * @brief Unlocks the inbox and wakes the consumer if the
+ * inbox got its first messages.
+ *
+ * @param inbox locked inbox structure.
+ */
+void shard_inbox_unlock(shard_inbox_t *inbox) {
+    uint8_t signal = (uint8_t)((inbox->signal == 1) && (inbox->len > 0));
+
+    /* The eventfd is cleared under the lock by the consumer */
+    if (signal == 1) {
+        eventfd_write(inbox->event_fd, 1);
+    }
+
+    pthread_mutex_unlock(&inbox->lock);
+}
+
+/**
+ * @brief Posts one message, see shard_inbox_append.
+ *
+ * @param inbox inbox structure.
+ * @param msg header of the message, the size and len fields are set.
+ * @param data data bytes of the message or NULL.
+ * @param len number of data bytes.
+ * @return err_t OK if the message was posted or SHARD_INBOX_FULL otherwise.
+ */
+err_t shard_inbox_post(shard_inbox_t *inbox, const shard_msg_t *msg, const void *data, size_t len) {
+    if ((inbox == NULL) || (msg == NULL)) {
+        return SHARD_INBOX_INPUT_IS_NULL;
+    }
+
+    shard_inbox_lock(inbox);
+
+    err_t err = shard_inbox_append(inbox, msg, data, len);
+
+    shard_inbox_unlock(inbox);
+
+    return err;
+}
+
+/**
+ * @brief Takes all the posted messages, the messages stay
+ * valid until the next call. Just the consumer calls it.
+ *
+ * @param inbox inbox structure.
+ * @param buf pointer to variable to set the messages.
+ * @param len pointer to variable to set the bytes of the messages.
+ * @return err_t OK if the messages were taken or error otherwise.
+ */
+err_t shard_inbox_take(shard_inbox_t *inbox, uint8_t **buf, size_t *len) {
+    if ((inbox == NULL) || (buf == NULL) || (len == NULL)) {
+        return SHARD_INBOX_INPUT_IS_NULL;
+    }
+
+    eventfd_t events = 0;
+
+    pthread_mutex_lock(&inbox->lock);
+
+    uint8_t *taken = inbox->buf;
+    size_t taken_capacity = inbox->capacity;
+
+    *len = inbox->len;
+
+    inbox->buf = inbox->spare;
+    inbox->capacity = inbox->spare_capacity;
+    inbox->len = 0;
+
+    inbox->spare = taken;
+    inbox->spare_capacity = taken_capacity;
+
+    eventfd_read(inbox->event_fd, &events);
+
+    pthread_mutex_unlock(&inbox->lock);
+
+    *buf = taken;
+
+    return OK;
+}
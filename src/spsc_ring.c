@@ -0,0 +1,301 @@
+/**
+ * @file spsc_ring.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/spsc_ring.h"
+
+#define spsc_ring_align(len) (((len) + SPSC_RING_ALIGN - 1) & ~(SPSC_RING_ALIGN - 1))
+
+/**
+ * @brief Creates an empty ring.
+ *
+ * @param ring pointer to ring structure to allocate, must be NULL.
+ * @param capacity ring bytes, rounded up to a power of two.
+ * @return err_t OK if the ring was allocated or error otherwise.
+ */
+err_t create_spsc_ring(spsc_ring_t **ring, size_t capacity) {
+    if ((ring == NULL) || (*ring != NULL)) {
+        return SPSC_RING_INPUT_IS_NOT_NULL;
+    }
+
+    size_t ring_len = CACHE_LINE_LEN;
+
+    while (ring_len < capacity) {
+        ring_len *= REALLOC_FACTOR;
+    }
+
+    if (posix_memalign((void **)ring, CACHE_LINE_LEN, sizeof **ring) != 0) {
+        *ring = NULL;
+
+        return SPSC_RING_FAILED_ALLOCATION;
+    }
+
+    memset(*ring, 0, sizeof **ring);
+
+    (*ring)->capacity = ring_len;
+    (*ring)->buf = malloc(ring_len);
+    (*ring)->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (((*ring)->buf == NULL) || ((*ring)->event_fd < 0)) {
+        if ((*ring)->event_fd >= 0) {
+            close((*ring)->event_fd);
+        }
+
+        free((*ring)->buf);
+        free(*ring);
+        *ring = NULL;
+
+        return SPSC_RING_FAILED_ALLOCATION;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Frees a ring and sets it to NULL, the entries are dropped.
+ *
+ * @param ring pointer to ring structure.
+ * @return err_t OK if the ring was freed or error otherwise.
+ */
+err_t free_spsc_ring(spsc_ring_t **ring) {
+    if ((ring == NULL) || (*ring == NULL)) {
+        return SPSC_RING_INPUT_IS_NULL;
+    }
+
+    close((*ring)->event_fd);
+
+    free((*ring)->buf);
+    free(*ring);
+    *ring = NULL;
+
+    return OK;
+}
+
+/**
+ * @brief Reserves an entry of at most max_len data bytes, the entry
+ * is added by spsc_ring_commit. Just the producer calls it.
+ *
+ * @param ring ring structure.
+ * @param max_len max data bytes of the entry.
+ * @param data pointer to variable to set the data of the entry.
+ * @return err_t OK if the entry was reserved or SPSC_RING_FULL otherwise.
+ */
+err_t spsc_ring_reserve(spsc_ring_t *ring, size_t max_len, uint8_t **data) {
+    size_t size = spsc_ring_align(sizeof (spsc_entry_t) + max_len);
+    size_t offset = ring->pending & (ring->capacity - 1);
+    size_t filler = ring->capacity - offset < size ? ring->capacity - offset : 0;
+
+    /* Look at the consumer position just when the cached one is not enough */
+    if (ring->pending + filler + size - ring->tail_cache > ring->capacity) {
+        ring->tail_cache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+        if (ring->pending + filler + size - ring->tail_cache > ring->capacity) {
+            ring->full++;
+
+            return SPSC_RING_FULL;
+        }
+    }
+
+    /* The entry does not fit before the end of the buffer */
+    if (filler > 0) {
+        spsc_entry_t *entry = (spsc_entry_t *)(ring->buf + offset);
+
+        entry->size = (uint32_t)filler;
+        entry->len = SPSC_RING_WRAP;
+
+        ring->pending += filler;
+    }
+
+    ring->reserved = ring->pending;
+
+    *data = ((spsc_entry_t *)(ring->buf + (ring->reserved & (ring->capacity - 1))))->data;
+
+    return OK;
+}
+
+/**
+ * @brief Adds the reserved entry with its actual length, the entry
+ * is seen by the consumer after spsc_ring_publish.
+ *
+ * @param ring ring structure.
+ * @param len data bytes of the entry, at most the reserved length.
+ */
+void spsc_ring_commit(spsc_ring_t *ring, size_t len) {
+    spsc_entry_t *entry = (spsc_entry_t *)(ring->buf + (ring->reserved & (ring->capacity - 1)));
+
+    entry->size = (uint32_t)spsc_ring_align(sizeof (spsc_entry_t) + len);
+    entry->len = (uint32_t)len;
+
+    ring->pending = ring->reserved + entry->size;
+}
+
+/**
+ * @brief Publishes the committed entries to the consumer and wakes
+ * it if it drained the ring. Just the producer calls it.
+ *
+ * @param ring ring structure.
+ */
+void spsc_ring_publish(spsc_ring_t *ring) {
+    size_t published = ring->head;
+
+    if (ring->pending == published) {
+        return;
+    }
+
+    __atomic_store_n(&ring->head, ring->pending, __ATOMIC_RELEASE);
+
+    /*
+     * Pairs with the fence of the consumer before it sleeps, either the
+     * consumer sees the new entries or the producer sees it drained them
+     */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    ring->tail_cache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (ring->tail_cache == published) {
+        eventfd_write(ring->event_fd, 1);
+    }
+}
+
+/**
+ * @brief Clears the wakeup of the consumer, the consumer calls it
+ * before taking the entries.
+ *
+ * @param ring ring structure.
+ */
+void spsc_ring_ack(spsc_ring_t *ring) {
+    eventfd_t events = 0;
+
+    eventfd_read(ring->event_fd, &events);
+}
+
+/**
+ * @brief Takes the next entry, the entry stays valid until the next call.
+ * The published entries are taken in batches, the space of a batch is
+ * released when the next batch is taken. When the ring is empty the
+ * consumer is woken by the next publish. Just the consumer calls it.
+ *
+ * @param ring ring structure.
+ * @param data pointer to variable to set the data of the entry.
+ * @param len pointer to variable to set the data bytes of the entry.
+ * @return err_t OK if an entry was taken or SPSC_RING_EMPTY otherwise.
+ */
+err_t spsc_ring_next(spsc_ring_t *ring, uint8_t **data, size_t *len) {
+    loop {
+        if (ring->next == ring->head_cache) {
+            /* Release the batch, then look for a new one */
+            __atomic_store_n(&ring->tail, ring->next, __ATOMIC_RELEASE);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+            ring->head_cache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+            if (ring->next == ring->head_cache) {
+                return SPSC_RING_EMPTY;
+            }
+
+            ring->batches++;
+
+            if (ring->head_cache - ring->next > ring->max_depth) {
+                ring->max_depth = ring->head_cache - ring->next;
+            }
+        }
+
+        spsc_entry_t *entry = (spsc_entry_t *)(ring->buf + (ring->next & (ring->capacity - 1)));
+
+        ring->next += entry->size;
+
+        if (entry->len != SPSC_RING_WRAP) {
+            ring->entries++;
+
+            *data = entry->data;
+            *len = entry->len;
+
+            return OK;
+        }
+    }
+}
+
+/**
+ * @brief Gets the bytes waiting in the ring, the value is
+ * approximate while the producer and the consumer run.
+ *
+ * @param ring ring structure.
+ * @return size_t bytes of the published entries not released yet.
+ */
+size_t spsc_ring_depth(spsc_ring_t *ring) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+/**
+ * @brief Gets the monotonic time in ns.
+ *
+ * @return uint64_t monotonic time.
+ */
+uint64_t stage_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Marks the start of a busy period of a stage.
+ *
+ * @param stats stage counters.
+ */
+void stage_busy(stage_stats_t *stats) {
+    stats->mark_ns = stage_now_ns();
+
+    if (stats->started_ns == 0) {
+        stats->started_ns = stats->mark_ns;
+    }
+}
+
+/**
+ * @brief Marks the end of a busy period of a stage.
+ *
+ * @param stats stage counters.
+ */
+void stage_idle(stage_stats_t *stats) {
+    stats->busy_ns += stage_now_ns() - stats->mark_ns;
+}
+
+/**
+ * @brief Gets the busy time of a stage since its start, in percents.
+ *
+ * @param stats stage counters.
+ * @return double busy percents.
+ */
+double stage_busy_percent(const stage_stats_t *stats) {
+    uint64_t elapsed = stage_now_ns() - stats->started_ns;
+
+    if ((stats->started_ns == 0) || (elapsed == 0)) {
+        return 0.0;
+    }
+
+    return 100.0 * (double)stats->busy_ns / (double)elapsed;
+}
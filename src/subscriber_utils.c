@@ -56,8 +56,16 @@ static int init_client_tcp_socket(client_t *client, const char *ip, const uint16
     client->send_msg->len = strlen(client->id) + 1;
     strcpy(client->send_msg->data, client->id);
 
-    /* Server accepted the connection send the ID */
-    if (send_tcp_msg(client->tcp_socket, (void *)client->send_msg, sizeof *client->send_msg) != OK) {
+    /* Server accepted the connection send the protocol version and the ID */
+    if (send_tcp_hello(client->tcp_socket) != OK) {
+        return -1;
+    }
+
+    if (send_tcp_frame(client->tcp_socket, client->send_msg, TCP_PROTO_FRAMED) != OK) {
+        return -1;
+    }
+
+    if (init_tcp_reader(&client->reader, TCP_PROTO_FRAMED) != OK) {
         return -1;
     }
 
@@ -82,7 +90,7 @@ static int init_client_poll_vec(client_t *client) {
     }
 
     /* Add the TCP server socket file descriptor */
-    if (poll_vec_add_fd(client->poll_vec, client->tcp_socket, POLLIN | POLLOUT) != OK) {
+    if (poll_vec_add_fd(client->poll_vec, client->tcp_socket, POLLIN) != OK) {
         free_poll_vec(&client->poll_vec);
         return -1;
     }
@@ -191,6 +199,7 @@ err_t init_client(client_t **client, const char *id, const char *ip, const uint1
     (*client)->poll_vec = NULL;
     if (init_client_poll_vec(*client) < 0) {
         close((*client)->tcp_socket);
+        free_tcp_reader(&(*client)->reader);
         free((*client)->id);
         free((*client)->cmd);
         free((*client)->send_msg);
@@ -237,6 +246,8 @@ err_t free_client(client_t **client) {
         free((*client)->recv_msg);
     }
 
+    free_tcp_reader(&(*client)->reader);
+
     free(*client);
     *client = NULL;
 
@@ -291,22 +302,29 @@ err_t process_ready_fds(client_t *this) {
 
     err_t err = OK;
 
-    if ((this->poll_vec->pfds[1].revents & POLLIN) != 0) {
+    if ((this->poll_vec->pfds[1].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
 
-        /* Receive an encapsulated TCP protocol message from the server side */
-        err = recv_tcp_msg(this->tcp_socket, (void *)this->recv_msg, sizeof *this->recv_msg);
+        /* Receive the available bytes of the encapsulated TCP protocol frames */
+        err = tcp_reader_fill(this->tcp_socket, &this->reader);
 
-        if (err == TCP_FAILED_SEND_RECV) {
+        if (err == TCP_WOULD_BLOCK) {
+            return OK;
+        } else if (err == TCP_FAILED_SEND_RECV) {
             /* Server closed the connection so exit the main thread */
 
             return OK_WITH_EXIT;
         } else if (err != OK) {
             return err;
-        } else {
-            /* Print the data received from the server which is a topic data */
+        }
 
+        /* Print every complete frame, the partial one waits for the next read */
+        while ((err = tcp_reader_next(&this->reader, this->recv_msg)) == OK) {
             printf("%s\n", this->recv_msg->data);
         }
+
+        if (err != TCP_FRAME_INCOMPLETE) {
+            return err;
+        }
     }
 
     return OK;
@@ -362,7 +380,7 @@ err_t process_subscribe_cmd(client_t *this) {
     this->send_msg->len += send_offset;
 
     /* Send the request to the server side */
-    return send_tcp_msg(this->tcp_socket, (void *)this->send_msg, sizeof *this->send_msg);
+    return send_tcp_frame(this->tcp_socket, this->send_msg, TCP_PROTO_FRAMED);
 }
 
 /**
@@ -407,7 +425,7 @@ err_t process_unsubscribe_cmd(client_t *this) {
     this->send_msg->len += send_offset;
 
     /* Send the request to the server side */
-    return send_tcp_msg(this->tcp_socket, (void *)this->send_msg, sizeof *this->send_msg);
+    return send_tcp_frame(this->tcp_socket, this->send_msg, TCP_PROTO_FRAMED);
 }
 
 /**
@@ -105,3 +105,799 @@ err_t recv_tcp_msg(const int tcp_socket, void *buf, size_t buf_len) {
 
     return OK;
 }
+
+/**
+ * @brief Sends a protocol message as a single frame, a framed
+ * peer gets just the header and the `len` data bytes.
+ *
+ * @param tcp_socket socket fd to send the frame.
+ * @param msg message to send, `len` is in host byte order.
+ * @param proto wire format of the peer.
+ * @return err_t OK if the frame was sent or TCP_FAILED_SEND_RECV otherwise.
+ */
+err_t send_tcp_frame(const int tcp_socket, tcp_msg_t *msg, tcp_proto_t proto) {
+    if (msg == NULL) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    if (proto == TCP_PROTO_LEGACY) {
+        return send_tcp_msg(tcp_socket, (void *)msg, sizeof *msg);
+    }
+
+    if (msg->len > MAX_TCP_MSG_BUF_LEN) {
+        return TCP_INVALID_FRAME;
+    }
+
+    /* Header and data are sent with a single call */
+    uint16_t len = msg->len;
+    msg->len = htons(len);
+
+    err_t err = send_tcp_msg(tcp_socket, (void *)msg, TCP_FRAME_HDR_LEN + len);
+
+    msg->len = len;
+
+    return err;
+}
+
+/**
+ * @brief Receives exactly one frame on a blocking socket.
+ *
+ * @param tcp_socket socket fd to receive the frame.
+ * @param msg message to fill, `len` is set in host byte order.
+ * @param proto wire format of the peer.
+ * @return err_t OK if a frame was received or error otherwise.
+ */
+err_t recv_tcp_frame(const int tcp_socket, tcp_msg_t *msg, tcp_proto_t proto) {
+    if (msg == NULL) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    err_t err = OK;
+
+    if (proto == TCP_PROTO_LEGACY) {
+        return recv_tcp_msg(tcp_socket, (void *)msg, sizeof *msg);
+    }
+
+    if ((err = recv_tcp_msg(tcp_socket, (void *)&msg->len, TCP_FRAME_HDR_LEN)) != OK) {
+        return err;
+    }
+
+    msg->len = ntohs(msg->len);
+
+    if (msg->len > MAX_TCP_MSG_BUF_LEN) {
+        return TCP_INVALID_FRAME;
+    }
+
+    if ((msg->len != 0) && ((err = recv_tcp_msg(tcp_socket, msg->data, msg->len)) != OK)) {
+        return err;
+    }
+
+    if (msg->len < MAX_TCP_MSG_BUF_LEN) {
+        msg->data[msg->len] = '\0';
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Sends the framed protocol handshake.
+ *
+ * @param tcp_socket socket fd to send the handshake.
+ * @return err_t OK if the handshake was sent or TCP_FAILED_SEND_RECV otherwise.
+ */
+err_t send_tcp_hello(const int tcp_socket) {
+    tcp_hello_t hello = {
+        .magic = TCP_PROTO_MAGIC,
+        .version = TCP_PROTO_VERSION
+    };
+
+    return send_tcp_msg(tcp_socket, (void *)&hello, sizeof hello);
+}
+
+/**
+ * @brief Receives the first frame of a new connection and detects
+ * the wire format of the peer by its first byte.
+ *
+ * @param tcp_socket socket fd of the new connection.
+ * @param msg message to fill with the first frame.
+ * @param proto pointer to variable to set the wire format of the peer.
+ * @return err_t OK if the frame was received or error otherwise.
+ */
+err_t recv_tcp_handshake(const int tcp_socket, tcp_msg_t *msg, tcp_proto_t *proto) {
+    if ((msg == NULL) || (proto == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    err_t err = OK;
+    tcp_hello_t hello;
+
+    if ((err = recv_tcp_msg(tcp_socket, (void *)&hello.magic, sizeof hello.magic)) != OK) {
+        return err;
+    }
+
+    if (hello.magic != TCP_PROTO_MAGIC) {
+        /* Legacy peer, the byte is the start of a full tcp_msg_t */
+
+        *proto = TCP_PROTO_LEGACY;
+        *(uint8_t *)msg = hello.magic;
+
+        return recv_tcp_msg(tcp_socket, (uint8_t *)msg + 1, sizeof *msg - 1);
+    }
+
+    if ((err = recv_tcp_msg(tcp_socket, (void *)&hello.version, sizeof hello.version)) != OK) {
+        return err;
+    }
+
+    if ((hello.version == 0) || (hello.version > TCP_PROTO_VERSION)) {
+        return TCP_UNSUPPORTED_VERSION;
+    }
+
+    *proto = TCP_PROTO_FRAMED;
+
+    return recv_tcp_frame(tcp_socket, msg, TCP_PROTO_FRAMED);
+}
+
+/**
+ * @brief Inits a frame reader for a peer.
+ *
+ * @param reader reader structure.
+ * @param proto wire format of the peer.
+ * @return err_t OK if the reader buffer was allocated or error otherwise.
+ */
+err_t init_tcp_reader(tcp_reader_t *reader, tcp_proto_t proto) {
+    if (reader == NULL) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    /* The largest frame of both formats always fits */
+    reader->proto = proto;
+    reader->start = 0;
+    reader->end = 0;
+    reader->capacity = sizeof (tcp_msg_t);
+    reader->buf = malloc(reader->capacity);
+
+    if (reader->buf == NULL) {
+        return TCP_FAILED_ALLOCATION;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Frees the buffer of a frame reader.
+ *
+ * @param reader reader structure.
+ */
+void free_tcp_reader(tcp_reader_t *reader) {
+    if (reader == NULL) {
+        return;
+    }
+
+    if (reader->buf != NULL) {
+        free(reader->buf);
+    }
+
+    reader->buf = NULL;
+    reader->start = 0;
+    reader->end = 0;
+    reader->capacity = 0;
+}
+
+/**
+ * @brief Reads the available bytes of a socket into the reader
+ * without blocking.
+ *
+ * @param tcp_socket socket fd to read from.
+ * @param reader reader structure.
+ * @return err_t OK if bytes were read, TCP_WOULD_BLOCK if no bytes
+ * are available or TCP_FAILED_SEND_RECV if the connection is closed.
+ */
+err_t tcp_reader_fill(const int tcp_socket, tcp_reader_t *reader) {
+    if (tcp_socket < 0) {
+        return TCP_INPUT_SOCKET_INVALID;
+    }
+
+    if ((reader == NULL) || (reader->buf == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    /* Move the partial frame at the start of the buffer */
+    if (reader->start == reader->end) {
+        reader->start = 0;
+        reader->end = 0;
+    } else if (reader->start != 0) {
+        memmove(reader->buf, reader->buf + reader->start, reader->end - reader->start);
+
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+
+    if (reader->end == reader->capacity) {
+        return TCP_INVALID_FRAME;
+    }
+
+    ssize_t tcp_bytes = recv(
+        tcp_socket,
+        reader->buf + reader->end,
+        reader->capacity - reader->end,
+        MSG_DONTWAIT
+    );
+
+    if (tcp_bytes < 0) {
+        if ((errno == EAGAIN) || (errno == EINTR)) {
+            return TCP_WOULD_BLOCK;
+        }
+
+        return TCP_FAILED_SEND_RECV;
+    }
+
+    if (tcp_bytes == 0) {
+        /* Conection is closed */
+
+        return TCP_FAILED_SEND_RECV;
+    }
+
+    reader->end += (size_t)tcp_bytes;
+
+    return OK;
+}
+
+/**
+ * @brief Extracts the next complete frame from the reader.
+ *
+ * @param reader reader structure.
+ * @param msg message to fill, `len` is set in host byte order.
+ * @return err_t OK if a frame was extracted, TCP_FRAME_INCOMPLETE if
+ * more bytes are needed or TCP_INVALID_FRAME for a malformed header.
+ */
+err_t tcp_reader_next(tcp_reader_t *reader, tcp_msg_t *msg) {
+    if ((reader == NULL) || (reader->buf == NULL) || (msg == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    size_t available = reader->end - reader->start;
+
+    if (reader->proto == TCP_PROTO_LEGACY) {
+        if (available < sizeof *msg) {
+            return TCP_FRAME_INCOMPLETE;
+        }
+
+        memcpy(msg, reader->buf + reader->start, sizeof *msg);
+        reader->start += sizeof *msg;
+
+        return OK;
+    }
+
+    if (available < TCP_FRAME_HDR_LEN) {
+        return TCP_FRAME_INCOMPLETE;
+    }
+
+    uint16_t len = 0;
+    memcpy(&len, reader->buf + reader->start, TCP_FRAME_HDR_LEN);
+    len = ntohs(len);
+
+    if (len > MAX_TCP_MSG_BUF_LEN) {
+        return TCP_INVALID_FRAME;
+    }
+
+    if (available < TCP_FRAME_HDR_LEN + len) {
+        return TCP_FRAME_INCOMPLETE;
+    }
+
+    msg->len = len;
+    memcpy(msg->data, reader->buf + reader->start + TCP_FRAME_HDR_LEN, len);
+
+    if (len < MAX_TCP_MSG_BUF_LEN) {
+        msg->data[len] = '\0';
+    }
+
+    reader->start += TCP_FRAME_HDR_LEN + len;
+
+    return OK;
+}
+
+/**
+ * @brief Serializes a protocol message into a shared frame
+ * holding one reference.
+ *
+ * @param frame pointer to frame to allocate, MUST be NULL.
+ * @param msg message to serialize, `len` is in host byte order.
+ * @return err_t OK if the frame was allocated or error otherwise.
+ */
+err_t create_tcp_frame(tcp_frame_t **frame, const tcp_msg_t *msg) {
+    if ((frame == NULL) || (*frame != NULL) || (msg == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    if (msg->len > MAX_TCP_MSG_BUF_LEN) {
+        return TCP_INVALID_FRAME;
+    }
+
+    *frame = malloc(sizeof **frame + TCP_FRAME_HDR_LEN + msg->len);
+    if (*frame == NULL) {
+        return TCP_FAILED_ALLOCATION;
+    }
+
+    uint16_t len = htons(msg->len);
+
+    (*frame)->refs = 1;
+    (*frame)->len = msg->len;
+    (*frame)->seq = 0;
+    (*frame)->legacy = NULL;
+
+    memcpy((*frame)->buf, &len, TCP_FRAME_HDR_LEN);
+    memcpy((*frame)->buf + TCP_FRAME_HDR_LEN, msg->data, msg->len);
+
+    return OK;
+}
+
+/**
+ * @brief Takes one more reference of a shared frame.
+ *
+ * @param frame shared frame.
+ * @return tcp_frame_t* the same frame.
+ */
+tcp_frame_t* tcp_frame_acquire(tcp_frame_t *frame) {
+    if (frame != NULL) {
+        (frame->refs)++;
+    }
+
+    return frame;
+}
+
+/**
+ * @brief Releases one reference of a shared frame, the last
+ * reference frees the frame. The pointer is set to NULL.
+ *
+ * @param frame pointer to shared frame.
+ */
+void tcp_frame_release(tcp_frame_t **frame) {
+    if ((frame == NULL) || (*frame == NULL)) {
+        return;
+    }
+
+    if (--((*frame)->refs) == 0) {
+        if ((*frame)->legacy != NULL) {
+            free((*frame)->legacy);
+        }
+
+        free(*frame);
+    }
+
+    *frame = NULL;
+}
+
+/**
+ * @brief Gets the bytes of a shared frame in the wire format of a peer,
+ * the fixed size encoding of a legacy peer is built once on demand.
+ *
+ * @param frame shared frame.
+ * @param proto wire format of the peer.
+ * @param frame_len pointer to variable to set the number of bytes.
+ * @return uint8_t* the encoded bytes or NULL if they could not be allocated.
+ */
+static uint8_t* tcp_frame_wire(tcp_frame_t *frame, tcp_proto_t proto, size_t *frame_len) {
+    if (proto == TCP_PROTO_FRAMED) {
+        *frame_len = TCP_FRAME_HDR_LEN + frame->len;
+
+        return frame->buf;
+    }
+
+    *frame_len = sizeof (tcp_msg_t);
+
+    if (frame->legacy == NULL) {
+        tcp_msg_t *msg = calloc(1, sizeof *msg);
+
+        if (msg == NULL) {
+            return NULL;
+        }
+
+        msg->len = frame->len;
+        memcpy(msg->data, frame->buf + TCP_FRAME_HDR_LEN, frame->len);
+
+        frame->legacy = (uint8_t *)msg;
+    }
+
+    return frame->legacy;
+}
+
+/**
+ * @brief Inits an outbound queue for a peer.
+ *
+ * @param writer writer structure.
+ * @param proto wire format of the peer.
+ * @param limit max number of queued bytes.
+ * @return err_t OK if the queue was allocated or error otherwise.
+ */
+err_t init_tcp_writer(tcp_writer_t *writer, tcp_proto_t proto, size_t limit) {
+    if (writer == NULL) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    writer->proto = proto;
+    writer->head = 0;
+    writer->len = 0;
+    writer->sent = 0;
+    writer->bytes = 0;
+    writer->limit = limit;
+    writer->async = 0;
+    writer->inflight = 0;
+    writer->iovs = NULL;
+    writer->capacity = INIT_TCP_WRITER_LEN;
+    writer->frames = malloc(sizeof *writer->frames * writer->capacity);
+
+    if (writer->frames == NULL) {
+        writer->capacity = 0;
+
+        return TCP_FAILED_ALLOCATION;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Frees the queued frames of an outbound queue.
+ *
+ * @param writer writer structure.
+ */
+void free_tcp_writer(tcp_writer_t *writer) {
+    if ((writer == NULL) || (writer->frames == NULL)) {
+        return;
+    }
+
+    for (size_t iter = 0; iter < writer->len; ++iter) {
+        tcp_frame_release(&writer->frames[(writer->head + iter) % writer->capacity]);
+    }
+
+    free(writer->frames);
+    free(writer->iovs);
+
+    writer->frames = NULL;
+    writer->iovs = NULL;
+    writer->inflight = 0;
+    writer->head = 0;
+    writer->len = 0;
+    writer->capacity = 0;
+    writer->sent = 0;
+    writer->bytes = 0;
+}
+
+/**
+ * @brief Queues a reference of a frame at the end of the queue.
+ *
+ * @param writer writer structure.
+ * @param frame shared frame.
+ * @param frame_len number of frame bytes in the wire format of the peer.
+ * @return err_t OK if the frame was queued or TCP_FAILED_ALLOCATION otherwise.
+ */
+static err_t tcp_writer_enqueue(tcp_writer_t *writer, tcp_frame_t *frame, size_t frame_len) {
+    /* Grow the ring and unwrap the frames at the start of the new ring */
+    if (writer->len == writer->capacity) {
+        tcp_frame_t **frames_real = malloc(
+            sizeof *writer->frames * writer->capacity * REALLOC_FACTOR
+        );
+
+        if (frames_real == NULL) {
+            return TCP_FAILED_ALLOCATION;
+        }
+
+        for (size_t iter = 0; iter < writer->len; ++iter) {
+            frames_real[iter] = writer->frames[(writer->head + iter) % writer->capacity];
+        }
+
+        free(writer->frames);
+
+        writer->frames = frames_real;
+        writer->head = 0;
+        writer->capacity *= REALLOC_FACTOR;
+    }
+
+    writer->frames[(writer->head + writer->len) % writer->capacity] = tcp_frame_acquire(frame);
+
+    (writer->len)++;
+    writer->bytes += frame_len;
+
+    return OK;
+}
+
+/**
+ * @brief Removes the oldest frame from the queue.
+ *
+ * @param writer writer structure.
+ * @param frame_len number of bytes of the oldest frame.
+ */
+static void tcp_writer_pop(tcp_writer_t *writer, size_t frame_len) {
+    writer->bytes -= frame_len - writer->sent;
+    writer->sent = 0;
+
+    tcp_frame_release(&writer->frames[writer->head]);
+
+    writer->head = (writer->head + 1) % writer->capacity;
+    (writer->len)--;
+}
+
+/**
+ * @brief Gets the number of bytes of a queued frame.
+ *
+ * @param writer writer structure.
+ * @param frame queued frame.
+ * @return size_t number of bytes in the wire format of the peer.
+ */
+static size_t tcp_writer_frame_len(tcp_writer_t *writer, tcp_frame_t *frame) {
+    return writer->proto == TCP_PROTO_FRAMED ?
+        TCP_FRAME_HDR_LEN + frame->len : sizeof (tcp_msg_t);
+}
+
+/**
+ * @brief Gathers the oldest queued frames for one system call.
+ *
+ * @param writer writer structure with queued frames.
+ * @param iovs array of TCP_WRITER_IOV_LEN buffers.
+ * @return size_t number of gathered frames.
+ */
+static size_t tcp_writer_gather(tcp_writer_t *writer, struct iovec *iovs) {
+    size_t niovs = 0;
+
+    for (; (niovs < writer->len) && (niovs < TCP_WRITER_IOV_LEN); ++niovs) {
+        size_t frame_len = 0;
+        size_t offset = niovs == 0 ? writer->sent : 0;
+        uint8_t *buf = tcp_frame_wire(
+            writer->frames[(writer->head + niovs) % writer->capacity],
+            writer->proto,
+            &frame_len
+        );
+
+        iovs[niovs].iov_base = buf + offset;
+        iovs[niovs].iov_len = frame_len - offset;
+    }
+
+    return niovs;
+}
+
+/**
+ * @brief Releases the frames sent completely, the last
+ * frame can be partially sent.
+ *
+ * @param writer writer structure.
+ * @param bytes number of sent bytes.
+ */
+static void tcp_writer_consume(tcp_writer_t *writer, size_t bytes) {
+    while ((bytes > 0) && (writer->len > 0)) {
+        size_t frame_len = tcp_writer_frame_len(writer, writer->frames[writer->head]);
+        size_t frame_left = frame_len - writer->sent;
+
+        if (bytes < frame_left) {
+            writer->sent += bytes;
+            writer->bytes -= bytes;
+
+            break;
+        }
+
+        bytes -= frame_left;
+        tcp_writer_pop(writer, frame_len);
+    }
+}
+
+/**
+ * @brief Sends a shared frame without blocking. If the queue is
+ * empty the frame is sent right away and the frame is queued just
+ * if the socket could not take all of it, otherwise the frame is
+ * queued behind the older frames in order to keep the stream ordered.
+ * A queued frame holds its own reference. An async queue
+ * always queues the frame.
+ *
+ * @param tcp_socket non-blocking socket fd to send the frame.
+ * @param writer writer structure.
+ * @param frame shared frame to send.
+ * @return err_t OK if the frame was sent, TCP_WOULD_BLOCK if (a part of)
+ * the frame was queued, TCP_WRITER_FULL if the frame does not fit in the
+ * queue or TCP_FAILED_SEND_RECV if the connection is closed.
+ */
+err_t tcp_writer_send(const int tcp_socket, tcp_writer_t *writer, tcp_frame_t *frame) {
+    if (tcp_socket < 0) {
+        return TCP_INPUT_SOCKET_INVALID;
+    }
+
+    if ((writer == NULL) || (writer->frames == NULL) || (frame == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    size_t frame_len = 0;
+    uint8_t *buf = tcp_frame_wire(frame, writer->proto, &frame_len);
+
+    if (buf == NULL) {
+        return TCP_FAILED_ALLOCATION;
+    }
+
+    if ((writer->len != 0) || (writer->async == 1)) {
+        /* An empty queue always takes the rest of one frame */
+
+        if ((writer->len != 0) && (writer->bytes + frame_len > writer->limit)) {
+            return TCP_WRITER_FULL;
+        }
+
+        if (tcp_writer_enqueue(writer, frame, frame_len) != OK) {
+            return TCP_FAILED_ALLOCATION;
+        }
+
+        return TCP_WOULD_BLOCK;
+    }
+
+    /* Nothing is queued, try to send the frame right away */
+    size_t bytes_send = 0;
+
+    while (bytes_send < frame_len) {
+        ssize_t tcp_bytes = send(
+            tcp_socket,
+            buf + bytes_send,
+            frame_len - bytes_send,
+            MSG_DONTWAIT | MSG_NOSIGNAL
+        );
+
+        if (tcp_bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno != EAGAIN) {
+                return TCP_FAILED_SEND_RECV;
+            }
+
+            break;
+        }
+
+        bytes_send += (size_t)tcp_bytes;
+    }
+
+    if (bytes_send == frame_len) {
+        return OK;
+    }
+
+    if (tcp_writer_enqueue(writer, frame, frame_len) != OK) {
+        return TCP_FAILED_ALLOCATION;
+    }
+
+    writer->sent = bytes_send;
+    writer->bytes -= bytes_send;
+
+    return TCP_WOULD_BLOCK;
+}
+
+/**
+ * @brief Drops the oldest queued frame that was not partially sent
+ * and is not part of a submitted send.
+ *
+ * @param writer writer structure.
+ * @return err_t OK if a frame was dropped or TCP_WRITER_FULL
+ * if no frame can be dropped.
+ */
+err_t tcp_writer_drop_oldest(tcp_writer_t *writer) {
+    if ((writer == NULL) || (writer->frames == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    /* The partial frame and the submitted frames must be completed */
+    size_t kept = writer->inflight > 0 ? writer->inflight : (size_t)(writer->sent > 0);
+
+    if (writer->len <= kept) {
+        return TCP_WRITER_FULL;
+    }
+
+    size_t drop = (writer->head + kept) % writer->capacity;
+
+    writer->bytes -= tcp_writer_frame_len(writer, writer->frames[drop]);
+    tcp_frame_release(&writer->frames[drop]);
+
+    /* Move the kept frames over the dropped one */
+    for (size_t iter = kept; iter > 0; --iter) {
+        writer->frames[(writer->head + iter) % writer->capacity] =
+            writer->frames[(writer->head + iter - 1) % writer->capacity];
+    }
+
+    writer->head = (writer->head + 1) % writer->capacity;
+    (writer->len)--;
+
+    return OK;
+}
+
+/**
+ * @brief Sends the queued frames until the queue is empty or
+ * the socket cannot take more bytes.
+ *
+ * @param tcp_socket non-blocking socket fd to send the frames.
+ * @param writer writer structure.
+ * @return err_t OK if the queue is empty, TCP_WOULD_BLOCK if frames are
+ * left in the queue or TCP_FAILED_SEND_RECV if the connection is closed.
+ */
+err_t tcp_writer_flush(const int tcp_socket, tcp_writer_t *writer) {
+    if (tcp_socket < 0) {
+        return TCP_INPUT_SOCKET_INVALID;
+    }
+
+    if ((writer == NULL) || (writer->frames == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    struct iovec iovs[TCP_WRITER_IOV_LEN];
+
+    while (writer->len > 0) {
+        /* Gather several frames for one system call */
+        size_t niovs = tcp_writer_gather(writer, iovs);
+
+        struct msghdr hdr = {
+            .msg_iov = iovs,
+            .msg_iovlen = niovs
+        };
+
+        ssize_t tcp_bytes = sendmsg(tcp_socket, &hdr, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (tcp_bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN) {
+                return TCP_WOULD_BLOCK;
+            }
+
+            return TCP_FAILED_SEND_RECV;
+        }
+
+        /* Release the frames sent completely */
+        tcp_writer_consume(writer, (size_t)tcp_bytes);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Gathers the oldest frames of an async queue into one send,
+ * the frames are kept until the send is completed.
+ *
+ * @param writer writer structure.
+ * @param hdr pointer to variable to set the message to send.
+ * @return err_t OK if the send was prepared, TCP_WOULD_BLOCK if the queue
+ * is empty or a send is not completed yet or error otherwise.
+ */
+err_t tcp_writer_prepare(tcp_writer_t *writer, struct msghdr **hdr) {
+    if ((writer == NULL) || (writer->frames == NULL) || (hdr == NULL)) {
+        return TCP_INPUT_BUF_IS_NULL;
+    }
+
+    if ((writer->len == 0) || (writer->inflight > 0)) {
+        return TCP_WOULD_BLOCK;
+    }
+
+    if ((writer->iovs == NULL) &&
+        ((writer->iovs = malloc(sizeof *writer->iovs * TCP_WRITER_IOV_LEN)) == NULL)) {
+        return TCP_FAILED_ALLOCATION;
+    }
+
+    writer->inflight = tcp_writer_gather(writer, writer->iovs);
+
+    memset(&writer->hdr, 0, sizeof writer->hdr);
+
+    writer->hdr.msg_iov = writer->iovs;
+    writer->hdr.msg_iovlen = writer->inflight;
+
+    *hdr = &writer->hdr;
+
+    return OK;
+}
+
+/**
+ * @brief Completes the send of an async queue, the frames sent
+ * completely are released.
+ *
+ * @param writer writer structure.
+ * @param bytes number of sent bytes.
+ */
+void tcp_writer_complete(tcp_writer_t *writer, size_t bytes) {
+    if ((writer == NULL) || (writer->frames == NULL)) {
+        return;
+    }
+
+    writer->inflight = 0;
+
+    tcp_writer_consume(writer, bytes);
+}
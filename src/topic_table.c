@@ -0,0 +1,323 @@
+/**
+ * @file topic_table.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/topic_table.h"
+
+/**
+ * @brief Finds the bucket of a topic name or the empty bucket
+ * where the name should be inserted.
+ *
+ * @param table table structure.
+ * @param name topic name.
+ * @param hash hash of the topic name.
+ * @return uint32_t bucket index.
+ */
+static uint32_t topic_table_probe(topic_table_t *table, const char *name, uint64_t hash) {
+    uint32_t mask = table->buckets_len - 1;
+    uint32_t bucket = (uint32_t)hash & mask;
+
+    /* Linear probing, the table is never full */
+    while (table->buckets[bucket] != 0) {
+        topic_entry_t *entry = &table->entries[table->buckets[bucket] - 1];
+
+        if ((entry->hash == hash) && (strcmp(entry->name, name) == 0)) {
+            break;
+        }
+
+        bucket = (bucket + 1) & mask;
+    }
+
+    return bucket;
+}
+
+/**
+ * @brief Doubles the number of buckets and reinserts the topics.
+ *
+ * @param table table structure.
+ * @return err_t OK if the buckets were resized or error otherwise.
+ */
+static err_t topic_table_grow_buckets(topic_table_t *table) {
+    uint32_t buckets_len = table->buckets_len * REALLOC_FACTOR;
+
+    uint32_t *buckets = calloc(buckets_len, sizeof *buckets);
+    if (buckets == NULL) {
+        return TOPIC_TABLE_FAILED_ALLOCATION;
+    }
+
+    free(table->buckets);
+    table->buckets = buckets;
+    table->buckets_len = buckets_len;
+
+    for (uint32_t iter = 0; iter < table->len; ++iter) {
+        uint32_t bucket = topic_table_probe(table, table->entries[iter].name, table->entries[iter].hash);
+        table->buckets[bucket] = iter + 1;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Creates a topic table object.
+ *
+ * @param table pointer to table structure to allocate, must be NULL.
+ * @param init_topics initial number of topics to allocate.
+ * @return err_t OK if the table was allocated or error otherwise.
+ */
+err_t create_topic_table(topic_table_t **table, uint32_t init_topics) {
+    if ((table == NULL) || (*table != NULL)) {
+        return TOPIC_TABLE_INPUT_IS_NOT_NULL;
+    }
+
+    if (init_topics == 0) {
+        init_topics = 1;
+    }
+
+    *table = calloc(1, sizeof **table);
+    if (*table == NULL) {
+        return TOPIC_TABLE_FAILED_ALLOCATION;
+    }
+
+    (*table)->len = 0;
+    (*table)->capacity = init_topics;
+    (*table)->entries = malloc(sizeof *(*table)->entries * init_topics);
+
+    /* Smallest power of two with enough free buckets */
+    (*table)->buckets_len = 1;
+    while ((*table)->buckets_len < init_topics * TOPIC_TABLE_MAX_LOAD) {
+        (*table)->buckets_len <<= 1;
+    }
+
+    (*table)->buckets = calloc((*table)->buckets_len, sizeof *(*table)->buckets);
+
+    if (((*table)->entries == NULL) || ((*table)->buckets == NULL)) {
+        free_topic_table(table);
+        return TOPIC_TABLE_FAILED_ALLOCATION;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Frees a topic table object and sets it to NULL.
+ *
+ * @param table pointer to table structure.
+ * @return err_t OK if the table was freed or error otherwise.
+ */
+err_t free_topic_table(topic_table_t **table) {
+    if ((table == NULL) || (*table == NULL)) {
+        return TOPIC_TABLE_INPUT_IS_NULL;
+    }
+
+    if ((*table)->entries != NULL) {
+        for (uint32_t iter = 0; iter < (*table)->len; ++iter) {
+            free((*table)->entries[iter].name);
+            free((*table)->entries[iter].subs);
+        }
+
+        free((*table)->entries);
+    }
+
+    if ((*table)->buckets != NULL) {
+        free((*table)->buckets);
+    }
+
+    free(*table);
+    *table = NULL;
+
+    return OK;
+}
+
+/**
+ * @brief Finds the id of an interned topic.
+ *
+ * @param table table structure.
+ * @param name topic name.
+ * @param topic_id pointer to variable to set the topic id.
+ * @return err_t OK if the topic was found or TOPIC_TABLE_TOPIC_NOT_FOUND otherwise.
+ */
+err_t topic_table_find(topic_table_t *table, const char *name, uint32_t *topic_id) {
+    if ((table == NULL) || (name == NULL) || (topic_id == NULL)) {
+        return TOPIC_TABLE_INPUT_IS_NULL;
+    }
+
+    uint32_t bucket = topic_table_probe(table, name, hash_str(name));
+
+    if (table->buckets[bucket] == 0) {
+        return TOPIC_TABLE_TOPIC_NOT_FOUND;
+    }
+
+    *topic_id = table->buckets[bucket] - 1;
+
+    return OK;
+}
+
+/**
+ * @brief Interns a topic name, a new topic gets the next dense id.
+ *
+ * @param table table structure.
+ * @param name topic name.
+ * @param topic_id pointer to variable to set the topic id.
+ * @return err_t OK if the topic was found or added or error otherwise.
+ */
+err_t topic_table_intern(topic_table_t *table, const char *name, uint32_t *topic_id) {
+    if ((table == NULL) || (name == NULL) || (topic_id == NULL)) {
+        return TOPIC_TABLE_INPUT_IS_NULL;
+    }
+
+    err_t err = OK;
+    uint64_t hash = hash_str(name);
+    uint32_t bucket = topic_table_probe(table, name, hash);
+
+    if (table->buckets[bucket] != 0) {
+        *topic_id = table->buckets[bucket] - 1;
+        return OK;
+    }
+
+    /* Adds more memory for new topics */
+    if (table->len == table->capacity) {
+        topic_entry_t *entries_real = realloc(
+            table->entries,
+            sizeof *table->entries * table->capacity * REALLOC_FACTOR
+        );
+
+        if (entries_real == NULL) {
+            return TOPIC_TABLE_FAILED_ALLOCATION;
+        }
+
+        table->entries = entries_real;
+        table->capacity *= REALLOC_FACTOR;
+    }
+
+    topic_entry_t *entry = &table->entries[table->len];
+
+    entry->name = malloc(strlen(name) + 1);
+    if (entry->name == NULL) {
+        return TOPIC_TABLE_FAILED_ALLOCATION;
+    }
+
+    strcpy(entry->name, name);
+    entry->hash = hash;
+    entry->subs = NULL;
+    entry->subs_len = 0;
+    entry->subs_capacity = 0;
+
+    *topic_id = table->len;
+    (table->len)++;
+
+    /* Keep the load factor low so the probing sequences stay short */
+    if (table->len * TOPIC_TABLE_MAX_LOAD > table->buckets_len) {
+        if ((err = topic_table_grow_buckets(table)) != OK) {
+            (table->len)--;
+            free(entry->name);
+
+            return err;
+        }
+    } else {
+        table->buckets[bucket] = table->len;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Adds a subscriber to a topic, if the client is already
+ * subscribed just its store and forward option is updated.
+ *
+ * @param table table structure.
+ * @param topic_id valid topic id.
+ * @param client_idx index of the client in the clients vector.
+ * @param sf store and forward option.
+ * @return err_t OK if the subscriber was added or error otherwise.
+ */
+err_t topic_table_add_sub(topic_table_t *table, uint32_t topic_id, uint32_t client_idx, uint8_t sf) {
+    if (table == NULL) {
+        return TOPIC_TABLE_INPUT_IS_NULL;
+    }
+
+    if (topic_id >= table->len) {
+        return TOPIC_TABLE_TOPIC_NOT_FOUND;
+    }
+
+    topic_entry_t *entry = &table->entries[topic_id];
+
+    for (uint32_t iter = 0; iter < entry->subs_len; ++iter) {
+        if (entry->subs[iter].client_idx == client_idx) {
+            entry->subs[iter].sf = sf;
+            return OK;
+        }
+    }
+
+    /* Adds more memory for new subscribers */
+    if (entry->subs_len == entry->subs_capacity) {
+        uint32_t subs_capacity = entry->subs_capacity == 0 ?
+            INIT_TOPIC_SUBS_LEN : entry->subs_capacity * REALLOC_FACTOR;
+
+        topic_sub_t *subs_real = realloc(entry->subs, sizeof *entry->subs * subs_capacity);
+        if (subs_real == NULL) {
+            return TOPIC_TABLE_FAILED_ALLOCATION;
+        }
+
+        entry->subs = subs_real;
+        entry->subs_capacity = subs_capacity;
+    }
+
+    entry->subs[entry->subs_len].client_idx = client_idx;
+    entry->subs[entry->subs_len].sf = sf;
+    (entry->subs_len)++;
+
+    return OK;
+}
+
+/**
+ * @brief Removes a subscriber from a topic.
+ *
+ * @param table table structure.
+ * @param topic_id valid topic id.
+ * @param client_idx index of the client in the clients vector.
+ * @return err_t OK if the subscriber was removed or error otherwise.
+ */
+err_t topic_table_remove_sub(topic_table_t *table, uint32_t topic_id, uint32_t client_idx) {
+    if (table == NULL) {
+        return TOPIC_TABLE_INPUT_IS_NULL;
+    }
+
+    if (topic_id >= table->len) {
+        return TOPIC_TABLE_TOPIC_NOT_FOUND;
+    }
+
+    topic_entry_t *entry = &table->entries[topic_id];
+
+    for (uint32_t iter = 0; iter < entry->subs_len; ++iter) {
+        if (entry->subs[iter].client_idx == client_idx) {
+            /* The order of the subscribers does not matter */
+
+            entry->subs[iter] = entry->subs[entry->subs_len - 1];
+            (entry->subs_len)--;
+
+            return OK;
+        }
+    }
+
+    return TOPIC_TABLE_SUB_NOT_FOUND;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file udp_batch.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/udp_batch.h"
+
+/**
+ * @brief Creates a batch of datagram slots.
+ *
+ * @param batch pointer to batch structure to allocate, must be NULL.
+ * @param len number of datagram slots.
+ * @return err_t OK if the batch was allocated or error otherwise.
+ */
+err_t create_udp_batch(udp_batch_t **batch, size_t len) {
+    if ((batch == NULL) || (*batch != NULL)) {
+        return UDP_BATCH_INPUT_IS_NOT_NULL;
+    }
+
+    if (len == 0) {
+        len = 1;
+    }
+
+    *batch = calloc(1, sizeof **batch);
+    if (*batch == NULL) {
+        return UDP_BATCH_FAILED_ALLOCATION;
+    }
+
+    (*batch)->len = len;
+    (*batch)->bufs = calloc(len, UDP_SLOT_LEN);
+    (*batch)->iovs = calloc(len, sizeof *(*batch)->iovs);
+    (*batch)->msgs = calloc(len, sizeof *(*batch)->msgs);
+    (*batch)->addrs = calloc(len, sizeof *(*batch)->addrs);
+
+    if (((*batch)->bufs == NULL) || ((*batch)->iovs == NULL) ||
+        ((*batch)->msgs == NULL) || ((*batch)->addrs == NULL)) {
+        free_udp_batch(batch);
+        return UDP_BATCH_FAILED_ALLOCATION;
+    }
+
+    /* The slots are linked once and reused by every recvmmsg call */
+    for (size_t iter = 0; iter < len; ++iter) {
+        (*batch)->iovs[iter].iov_base = (*batch)->bufs + iter * UDP_SLOT_LEN;
+        (*batch)->iovs[iter].iov_len = UDP_SLOT_LEN;
+
+        (*batch)->msgs[iter].msg_hdr.msg_iov = &(*batch)->iovs[iter];
+        (*batch)->msgs[iter].msg_hdr.msg_iovlen = 1;
+        (*batch)->msgs[iter].msg_hdr.msg_name = &(*batch)->addrs[iter];
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Frees a batch of datagram slots and sets it to NULL.
+ *
+ * @param batch pointer to batch structure.
+ * @return err_t OK if the batch was freed or error otherwise.
+ */
+err_t free_udp_batch(udp_batch_t **batch) {
+    if ((batch == NULL) || (*batch == NULL)) {
+        return UDP_BATCH_INPUT_IS_NULL;
+    }
+
+    free((*batch)->bufs);
+    free((*batch)->iovs);
+    free((*batch)->msgs);
+    free((*batch)->addrs);
+
+    free(*batch);
+    *batch = NULL;
+
+    return OK;
+}
+
+/**
+ * @brief Receives up to max_msgs datagrams with a single recvmmsg
+ * call without blocking. The bytes after every datagram are cleared
+ * up to the end of its slot, so the parsers never read stale data.
+ *
+ * @param batch batch structure.
+ * @param udp_socket UDP socket to read from.
+ * @param max_msgs maximum number of datagrams to receive.
+ * @param nmsgs pointer to variable to set the number of received datagrams.
+ * @return err_t OK if the call succeeded (nmsgs can be 0) or error otherwise.
+ */
+err_t udp_batch_recv(udp_batch_t *batch, int udp_socket, size_t max_msgs, size_t *nmsgs) {
+    if ((batch == NULL) || (nmsgs == NULL)) {
+        return UDP_BATCH_INPUT_IS_NULL;
+    }
+
+    *nmsgs = 0;
+
+    if (max_msgs > batch->len) {
+        max_msgs = batch->len;
+    }
+
+    for (size_t iter = 0; iter < max_msgs; ++iter) {
+        batch->msgs[iter].msg_hdr.msg_namelen = sizeof batch->addrs[iter];
+        batch->msgs[iter].msg_len = 0;
+    }
+
+    int received = recvmmsg(udp_socket, batch->msgs, (unsigned int)max_msgs, MSG_DONTWAIT, NULL);
+
+    if (received < 0) {
+        if ((errno == EAGAIN) || (errno == EINTR)) {
+            return OK;
+        }
+
+        return UDP_BATCH_FAILED_RECV;
+    }
+
+    for (int iter = 0; iter < received; ++iter) {
+        size_t msg_len = batch->msgs[iter].msg_len;
+
+        if (msg_len < UDP_SLOT_LEN) {
+            memset(udp_batch_buf(batch, iter) + msg_len, 0, UDP_SLOT_LEN - msg_len);
+        }
+    }
+
+    *nmsgs = (size_t)received;
+
+    if (received > 0) {
+        batch->stats.batches++;
+        batch->stats.datagrams += (uint64_t)received;
+        batch->stats.last_batch = (uint64_t)received;
+
+        if ((uint64_t)received > batch->stats.max_batch) {
+            batch->stats.max_batch = (uint64_t)received;
+        }
+
+        if ((size_t)received == batch->len) {
+            batch->stats.full_batches++;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Gets the buffer of a datagram slot.
+ *
+ * @param batch batch structure.
+ * @param slot valid slot index.
+ * @return char* start of the slot buffer.
+ */
+char *udp_batch_buf(udp_batch_t *batch, size_t slot) {
+    return batch->bufs + slot * UDP_SLOT_LEN;
+}
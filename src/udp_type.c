@@ -25,68 +25,33 @@
 #include "./include/udp_type.h"
 
 /**
- * @brief Parses a int udp message type.
+ * @brief Reads a 32 bits number in network byte order.
  *
- * @param udp_type_var pointer to memory location to parse the message.
- * @param buf pointer to buffer containing the message bytes.
+ * @param buf pointer to the number bytes.
+ * @return uint32_t number in host byte order.
  */
-static void parse_udp_int_type(udp_type_t *udp_type_var, char *buf) {
-    uint8_t sign = *(uint8_t *)buf;
+static uint32_t read_net_u32(const char *buf) {
+    uint32_t value = 0;
 
-    udp_type_var->data.INT = ntohl(*(uint32_t *)(buf + 1));
+    memcpy(&value, buf, sizeof value);
 
-    if (sign != 0) {
-        udp_type_var->data.INT *= -1;
-    }
+    return ntohl(value);
 }
 
 /**
- * @brief Parses a short real udp message type.
+ * @brief Parses a buffer into a udp message record. The record is
+ * written in place, the caller must provide UDP_RECORD_MAX_LEN bytes.
+ * The topic id is not set, the topic name is copied in `topic` in
+ * order to be interned by the caller.
  *
- * @param udp_type_var pointer to memory location to parse the message.
- * @param buf pointer to buffer containing the message bytes.
- */
-static void parse_udp_short_real_type(udp_type_t *udp_type_var, char *buf) {
-    udp_type_var->data.SHORT_REAL = (1.0 * ntohs(*(uint16_t *)buf)) / 100;
-}
-
-/**
- * @brief Parses a float udp message type.
- *
- * @param udp_type_var pointer to memory location to parse the message.
- * @param buf pointer to buffer containing the message bytes.
- */
-static void parse_udp_float_type(udp_type_t *udp_type_var, char *buf) {
-    uint8_t sign = *(uint8_t *)buf;
-
-    udp_type_var->data.FLOAT = (1.0 * ntohl(*(uint32_t *)(buf + 1))) / ipow(10, *(uint8_t *)(buf + 1 + sizeof (uint32_t)));
-
-    if (sign != 0) {
-        udp_type_var->data.FLOAT *= -1.0;
-    }
-}
-
-/**
- * @brief Parses a string udp message type.
- *
- * @param udp_type_var pointer to memory location to parse the message.
- * @param buf pointer to buffer containing the message bytes.
- */
-static void parse_udp_string_type(udp_type_t *udp_type_var, char *buf) {
-    memset(udp_type_var->data.STRING, '\0', MAX_STRING_LEN);
-    memcpy(udp_type_var->data.STRING, buf, MAX_STRING_LEN);
-}
-
-/**
- * @brief Parses a buffer into a udp message type.
- *
- * @param udp_type_var pointer to memory location to parse the message.
+ * @param record pointer to memory location to parse the message.
  * @param addr pointer to memory location of the udp address information.
  * @param buf pointer to buffer containing the message bytes.
+ * @param topic buffer of MAX_TOPIC_LEN bytes to set the topic name.
  * @return err_t OK if parser executed successfully or UDP_* errors otherwise.
  */
-err_t parse_udp_type_from(udp_type_t *udp_type_var, struct sockaddr_in *addr, char *buf) {
-    if (udp_type_var == NULL) {
+err_t parse_udp_type_from(udp_record_t *record, struct sockaddr_in *addr, char *buf, char *topic) {
+    if ((record == NULL) || (topic == NULL)) {
         return UDP_INPUT_VAR_IS_NULL;
     }
 
@@ -94,66 +59,135 @@ err_t parse_udp_type_from(udp_type_t *udp_type_var, struct sockaddr_in *addr, ch
         return UDP_INPUT_BUF_IS_NULL;
     }
 
-    memset(&udp_type_var->addr, 0, sizeof udp_type_var->addr);
-    memcpy(&udp_type_var->addr, addr, sizeof udp_type_var);
+    /* The topic has at most 50 characters, the type byte follows it */
+    size_t topic_len = strnlen(buf, MAX_TOPIC_LEN - 1);
+
+    memcpy(topic, buf, topic_len);
+    topic[topic_len] = '\0';
 
-    memset(udp_type_var->topic, '\0', MAX_TOPIC_LEN);
-    memcpy(udp_type_var->topic, buf, MAX_TOPIC_LEN);
+    record->topic_id = 0;
+    record->ip = addr->sin_addr.s_addr;
+    record->port = addr->sin_port;
+    record->type = *(uint8_t *)(buf + MAX_TOPIC_LEN - 1);
 
-    udp_type_var->type = (udp_data_type_t)(*(uint8_t *)(buf + MAX_TOPIC_LEN - 1));
+    /* Keep just the payload bytes of the value */
+    char *payload = buf + MAX_TOPIC_LEN;
 
-    size_t buf_offset = MAX_TOPIC_LEN;
-    switch (udp_type_var->type) {
+    switch (record->type) {
         case INT:
-            parse_udp_int_type(udp_type_var, buf + buf_offset);
+            record->len = UDP_INT_LEN;
             break;
         case SHORT_REAL:
-            parse_udp_short_real_type(udp_type_var, buf + buf_offset);
+            record->len = UDP_SHORT_REAL_LEN;
             break;
         case FLOAT:
-            parse_udp_float_type(udp_type_var, buf + buf_offset);
+            record->len = UDP_FLOAT_LEN;
             break;
         case STRING:
-            parse_udp_string_type(udp_type_var, buf + buf_offset);
+            record->len = (uint16_t)strnlen(payload, MAX_STRING_LEN - 1);
             break;
         default:
             return UDP_UNKNOWN_DATA_TYPE;
     }
 
+    memcpy(record->payload, payload, record->len);
+    record->payload[record->len] = '\0';
+
     return OK;
 }
 
 /**
- * @brief Prints a parsed udp message type on stderr
+ * @brief Gets the number of bytes of a record, including the padding
+ * that keeps the next record aligned.
+ *
+ * @param record pointer to udp message record.
+ * @return size_t record bytes.
+ */
+size_t udp_record_size(const udp_record_t *record) {
+    return udp_record_align(offsetof (udp_record_t, payload) + record->len + 1);
+}
+
+/**
+ * @brief Decodes the value of an INT record.
+ *
+ * @param record pointer to udp message record.
+ * @return int32_t value of the message.
+ */
+int32_t udp_record_int(const udp_record_t *record) {
+    uint8_t sign = *(uint8_t *)record->payload;
+    int32_t value = (int32_t)read_net_u32(record->payload + 1);
+
+    if (sign != 0) {
+        value *= -1;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Decodes the value of a SHORT_REAL record.
+ *
+ * @param record pointer to udp message record.
+ * @return double value of the message.
+ */
+double udp_record_short_real(const udp_record_t *record) {
+    uint16_t value = 0;
+
+    memcpy(&value, record->payload, sizeof value);
+
+    return (1.0 * ntohs(value)) / 100;
+}
+
+/**
+ * @brief Decodes the value of a FLOAT record.
+ *
+ * @param record pointer to udp message record.
+ * @return double value of the message.
+ */
+double udp_record_float(const udp_record_t *record) {
+    uint8_t sign = *(uint8_t *)record->payload;
+    uint8_t power = *(uint8_t *)(record->payload + 1 + sizeof (uint32_t));
+    double value = (1.0 * read_net_u32(record->payload + 1)) / ipow(10, power);
+
+    if (sign != 0) {
+        value *= -1.0;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Prints a parsed udp message record on stderr
  * for debugging purposes.
  *
- * @param udp_type_var pointer to udp message type.
+ * @param record pointer to udp message record.
+ * @param topic topic name of the message.
  * @return err_t OK if printing went successfully.
  */
-err_t print_udp_type(udp_type_t *udp_type_var) {
-    if (udp_type_var == NULL) {
+err_t print_udp_type(udp_record_t *record, const char *topic) {
+    if ((record == NULL) || (topic == NULL)) {
         return UDP_INPUT_VAR_IS_NULL;
     }
 
     fprintf(stderr, "UDP Package:\n");
-    fprintf(stderr, "  topic: %s,\n", udp_type_var->topic);
+    fprintf(stderr, "  topic: %s,\n", topic);
 
-    switch (udp_type_var->type) {
+    switch (record->type) {
         case INT:
             fprintf(stderr, "  type: INT,\n");
-            fprintf(stderr, "  data: %d.\n\n", udp_type_var->data.INT);
+            fprintf(stderr, "  data: %d.\n\n", udp_record_int(record));
             break;
         case SHORT_REAL:
             fprintf(stderr, "  type: SHORT_REAL,\n");
-            fprintf(stderr, "  data: %.2f.\n\n", udp_type_var->data.SHORT_REAL);
+            fprintf(stderr, "  data: %.2f.\n\n", udp_record_short_real(record));
             break;
         case FLOAT:
             fprintf(stderr, "  type: FLOAT,\n");
-            fprintf(stderr, "  data: %f.\n\n", udp_type_var->data.FLOAT);
+            fprintf(stderr, "  data: %f.\n\n", udp_record_float(record));
             break;
         case STRING:
             fprintf(stderr, "  type: STRING,\n");
-            fprintf(stderr, "  data: %s.\n\n", udp_type_var->data.STRING);
+            fprintf(stderr, "  data: %s.\n\n", record->payload);
             break;
         default:
             return UDP_UNKNOWN_DATA_TYPE;
@@ -0,0 +1,398 @@
+/**
+ * @file uring.c
+ * @author Mihai Negru (determinant289@gmail.com)
+ * @version 1.0.0
+ * @date 2023-05-02
+ *
+ * @copyright Copyright (C) 2023-2024 Mihai Negru <determinant289@gmail.com>
+ * This file is part of tcp-client-server.
+ *
+ * tcp-client-server is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tcp-client-server is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tcp-client-server.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "./include/uring.h"
+
+/* The instance needs one mmap, completions kept on overflow and wait timeouts */
+#define URING_REQUIRED_FEATURES (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG)
+
+/**
+ * @brief Calls io_uring_enter, the call is restarted if it was interrupted.
+ *
+ * @param ring ring structure.
+ * @param to_submit number of queued operations to submit.
+ * @param min_complete number of completions to wait for.
+ * @param flags enter flags.
+ * @param arg extended argument or NULL.
+ * @return int number of submitted operations or -1 on error.
+ */
+static int uring_enter(uring_t *ring, uint32_t to_submit, uint32_t min_complete, uint32_t flags,
+    struct io_uring_getevents_arg *arg) {
+    int ret = 0;
+
+    do {
+        ring->stats.enters++;
+
+        ret = (int)syscall(
+            __NR_io_uring_enter,
+            ring->ring_fd,
+            to_submit,
+            min_complete,
+            flags,
+            arg,
+            arg != NULL ? sizeof *arg : 0
+        );
+    } while ((ret < 0) && (errno == EINTR));
+
+    if (ret > 0) {
+        ring->stats.sqes += (uint64_t)ret;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Makes the queued operations visible to the kernel.
+ *
+ * @param ring ring structure.
+ * @return uint32_t number of operations to submit.
+ */
+static uint32_t uring_flush_sq(uring_t *ring) {
+    uint32_t to_submit = ring->sqe_tail - *ring->sq_tail;
+
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+
+    return to_submit;
+}
+
+/**
+ * @brief Creates an io_uring instance.
+ *
+ * @param ring pointer to ring structure to allocate, must be NULL.
+ * @return err_t OK if the instance was created or error otherwise,
+ * URING_FAILED_SETUP if the kernel does not support the used features.
+ */
+err_t create_uring(uring_t **ring) {
+    if ((ring == NULL) || (*ring != NULL)) {
+        return URING_INPUT_IS_NOT_NULL;
+    }
+
+    *ring = calloc(1, sizeof **ring);
+    if (*ring == NULL) {
+        return URING_FAILED_ALLOCATION;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = URING_CQ_LEN;
+
+    (*ring)->ring_mem = MAP_FAILED;
+    (*ring)->sqes = MAP_FAILED;
+    (*ring)->ring_fd = (int)syscall(__NR_io_uring_setup, URING_SQ_LEN, &params);
+
+    if (((*ring)->ring_fd < 0) || ((params.features & URING_REQUIRED_FEATURES) != URING_REQUIRED_FEATURES)) {
+        free_uring(ring);
+
+        return URING_FAILED_SETUP;
+    }
+
+    /* The submission and the completion rings share one mapping */
+    size_t sq_len = params.sq_off.array + params.sq_entries * sizeof (uint32_t);
+    size_t cq_len = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+
+    (*ring)->ring_mem_len = sq_len > cq_len ? sq_len : cq_len;
+    (*ring)->ring_mem = mmap(NULL, (*ring)->ring_mem_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, (*ring)->ring_fd, IORING_OFF_SQ_RING);
+
+    (*ring)->sqes_len = params.sq_entries * sizeof (struct io_uring_sqe);
+    (*ring)->sqes = mmap(NULL, (*ring)->sqes_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, (*ring)->ring_fd, IORING_OFF_SQES);
+
+    if (((*ring)->ring_mem == MAP_FAILED) || ((*ring)->sqes == MAP_FAILED)) {
+        free_uring(ring);
+
+        return URING_FAILED_ALLOCATION;
+    }
+
+    uint8_t *mem = (*ring)->ring_mem;
+
+    (*ring)->sq_head = (uint32_t *)(mem + params.sq_off.head);
+    (*ring)->sq_tail = (uint32_t *)(mem + params.sq_off.tail);
+    (*ring)->sq_array = (uint32_t *)(mem + params.sq_off.array);
+    (*ring)->sq_mask = *(uint32_t *)(mem + params.sq_off.ring_mask);
+    (*ring)->sq_entries = params.sq_entries;
+    (*ring)->sqe_tail = *(*ring)->sq_tail;
+
+    (*ring)->cq_head = (uint32_t *)(mem + params.cq_off.head);
+    (*ring)->cq_tail = (uint32_t *)(mem + params.cq_off.tail);
+    (*ring)->cqes = (struct io_uring_cqe *)(mem + params.cq_off.cqes);
+    (*ring)->cq_mask = *(uint32_t *)(mem + params.cq_off.ring_mask);
+
+    return OK;
+}
+
+/**
+ * @brief Frees an io_uring instance and sets it to NULL, the
+ * pending operations are cancelled by the kernel.
+ *
+ * @param ring pointer to ring structure.
+ * @return err_t OK if the instance was freed or error otherwise.
+ */
+err_t free_uring(uring_t **ring) {
+    if ((ring == NULL) || (*ring == NULL)) {
+        return URING_INPUT_IS_NULL;
+    }
+
+    if ((*ring)->sqes != MAP_FAILED) {
+        munmap((*ring)->sqes, (*ring)->sqes_len);
+    }
+
+    if ((*ring)->ring_mem != MAP_FAILED) {
+        munmap((*ring)->ring_mem, (*ring)->ring_mem_len);
+    }
+
+    if ((*ring)->ring_fd >= 0) {
+        close((*ring)->ring_fd);
+    }
+
+    free((*ring)->buf_ring);
+    free((*ring)->bufs);
+
+    free(*ring);
+    *ring = NULL;
+
+    return OK;
+}
+
+/**
+ * @brief Gets a cleared submission entry, the queued entries are
+ * submitted first if the submission ring is full.
+ *
+ * @param ring ring structure.
+ * @param sqe pointer to variable to set the submission entry.
+ * @return err_t OK if an entry was found or URING_FAILED_SUBMIT otherwise.
+ */
+err_t uring_get_sqe(uring_t *ring, struct io_uring_sqe **sqe) {
+    if ((ring == NULL) || (sqe == NULL)) {
+        return URING_INPUT_IS_NULL;
+    }
+
+    if (ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+        if (uring_submit(ring) != OK) {
+            return URING_FAILED_SUBMIT;
+        }
+
+        if (ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+            return URING_FAILED_SUBMIT;
+        }
+    }
+
+    uint32_t idx = ring->sqe_tail & ring->sq_mask;
+
+    ring->sq_array[idx] = idx;
+    ring->sqe_tail++;
+
+    *sqe = &ring->sqes[idx];
+    memset(*sqe, 0, sizeof **sqe);
+
+    return OK;
+}
+
+/**
+ * @brief Submits the queued operations without waiting.
+ *
+ * @param ring ring structure.
+ * @return err_t OK if the operations were submitted or URING_FAILED_SUBMIT otherwise.
+ */
+err_t uring_submit(uring_t *ring) {
+    if (ring == NULL) {
+        return URING_INPUT_IS_NULL;
+    }
+
+    uint32_t to_submit = uring_flush_sq(ring);
+
+    if (to_submit == 0) {
+        return OK;
+    }
+
+    if ((uring_enter(ring, to_submit, 0, 0, NULL) < 0) && (errno != EAGAIN) && (errno != EBUSY)) {
+        return URING_FAILED_SUBMIT;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Submits the queued operations and waits for a completion,
+ * the wait is skipped if completions are left from the last reap.
+ *
+ * @param ring ring structure.
+ * @param timeout timeout in milliseconds or -1 to block.
+ * @return err_t OK if the wait returned (the completion ring can
+ * be empty on timeout) or URING_FAILED_SUBMIT otherwise.
+ */
+err_t uring_wait(uring_t *ring, int timeout) {
+    if (ring == NULL) {
+        return URING_INPUT_IS_NULL;
+    }
+
+    uint32_t to_submit = uring_flush_sq(ring);
+
+    if (uring_peek_cqe(ring) != NULL) {
+        return to_submit > 0 ? uring_submit(ring) : OK;
+    }
+
+    struct __kernel_timespec ts = {
+        .tv_sec = timeout / 1000,
+        .tv_nsec = (long long)(timeout % 1000) * 1000000
+    };
+
+    struct io_uring_getevents_arg arg = {
+        .sigmask = 0,
+        .sigmask_sz = _NSIG / 8,
+        .ts = (uint64_t)(uintptr_t)&ts
+    };
+
+    uint32_t flags = IORING_ENTER_GETEVENTS | (timeout >= 0 ? IORING_ENTER_EXT_ARG : 0);
+
+    if (uring_enter(ring, to_submit, 1, flags, timeout >= 0 ? &arg : NULL) < 0) {
+        /* A timeout or a full completion ring still returns the completions */
+        if ((errno != ETIME) && (errno != EAGAIN) && (errno != EBUSY)) {
+            return URING_FAILED_SUBMIT;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Gets the oldest completion without removing it.
+ *
+ * @param ring ring structure.
+ * @return struct io_uring_cqe* oldest completion or NULL if there is none.
+ */
+struct io_uring_cqe *uring_peek_cqe(uring_t *ring) {
+    uint32_t head = *ring->cq_head;
+
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+/**
+ * @brief Removes the oldest completion.
+ *
+ * @param ring ring structure.
+ */
+void uring_cqe_seen(uring_t *ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+
+    ring->stats.cqes++;
+}
+
+/**
+ * @brief Registers the provided buffers of the instance, it can
+ * be called once.
+ *
+ * @param ring ring structure.
+ * @param nbufs number of buffers, a power of two.
+ * @param buf_len bytes of every buffer.
+ * @return err_t OK if the buffers were registered or error otherwise.
+ */
+err_t uring_add_bufs(uring_t *ring, uint16_t nbufs, size_t buf_len) {
+    if (ring == NULL) {
+        return URING_INPUT_IS_NULL;
+    }
+
+    if ((ring->bufs != NULL) || (nbufs == 0) || ((nbufs & (nbufs - 1)) != 0)) {
+        return URING_INPUT_IS_NOT_NULL;
+    }
+
+    /* The kernel maps the ring of free buffers, it must be page aligned */
+    if (posix_memalign((void **)&ring->buf_ring, (size_t)sysconf(_SC_PAGESIZE),
+        nbufs * sizeof (struct io_uring_buf)) != 0) {
+        ring->buf_ring = NULL;
+
+        return URING_FAILED_ALLOCATION;
+    }
+
+    if ((ring->bufs = malloc(nbufs * buf_len)) == NULL) {
+        free(ring->buf_ring);
+        ring->buf_ring = NULL;
+
+        return URING_FAILED_ALLOCATION;
+    }
+
+    memset(ring->buf_ring, 0, nbufs * sizeof (struct io_uring_buf));
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof reg);
+
+    reg.ring_addr = (uint64_t)(uintptr_t)ring->buf_ring;
+    reg.ring_entries = nbufs;
+    reg.bgid = URING_BUF_GROUP;
+
+    if (syscall(__NR_io_uring_register, ring->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        free(ring->buf_ring);
+        free(ring->bufs);
+        ring->buf_ring = NULL;
+        ring->bufs = NULL;
+
+        return URING_FAILED_SETUP;
+    }
+
+    ring->nbufs = nbufs;
+    ring->buf_len = buf_len;
+    ring->buf_tail = 0;
+
+    for (uint16_t bid = 0; bid < nbufs; ++bid) {
+        uring_release_buf(ring, bid);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Gets a provided buffer selected by the kernel.
+ *
+ * @param ring ring structure.
+ * @param bid buffer id from the completion flags.
+ * @return uint8_t* start of the buffer.
+ */
+uint8_t *uring_buf(uring_t *ring, uint16_t bid) {
+    return ring->bufs + (size_t)bid * ring->buf_len;
+}
+
+/**
+ * @brief Gives a provided buffer back to the kernel.
+ *
+ * @param ring ring structure.
+ * @param bid buffer id from the completion flags.
+ */
+void uring_release_buf(uring_t *ring, uint16_t bid) {
+    /* The tail overlays the reserved field of the first entry */
+    struct io_uring_buf *buf = &ring->buf_ring->bufs[ring->buf_tail & (ring->nbufs - 1)];
+
+    buf->addr = (uint64_t)(uintptr_t)uring_buf(ring, bid);
+    buf->len = (uint32_t)ring->buf_len;
+    buf->bid = bid;
+
+    ring->buf_tail++;
+
+    __atomic_store_n(&ring->buf_ring->tail, ring->buf_tail, __ATOMIC_RELEASE);
+}
@@ -176,6 +176,147 @@ void debug_msg(const err_t error) {
         case INPUT_WRONG_FORMAT:
             fprintf(stderr, "[DEBUG] Input command has not a valid format.");
             break;
+        case POLL_VEC_FAILED_EPOLL:
+            fprintf(stderr, "[DEBUG] Could not create or update the epoll instance.");
+            break;
+        case POLL_VEC_FD_NOT_FOUND:
+            fprintf(stderr, "[DEBUG] File descriptor is not watched by the poll vector.");
+            break;
+        case SERVER_INVALID_CONFIG:
+            fprintf(stderr, "[DEBUG] Server command line options are not valid.");
+            break;
+        case TCP_WOULD_BLOCK:
+            fprintf(stderr, "[DEBUG] No bytes are available on the socket yet.");
+            break;
+        case TCP_FRAME_INCOMPLETE:
+            fprintf(stderr, "[DEBUG] The frame is not complete, more bytes are needed.");
+            break;
+        case TCP_INVALID_FRAME:
+            fprintf(stderr, "[DEBUG] The frame length exceeds the protocol limit.");
+            break;
+        case TCP_UNSUPPORTED_VERSION:
+            fprintf(stderr, "[DEBUG] The peer speaks an unsupported protocol version.");
+            break;
+        case TCP_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Could not allocate the frame reader buffer.");
+            break;
+        case TOPIC_TABLE_INPUT_IS_NOT_NULL:
+            fprintf(stderr, "[DEBUG] Input topic table must be NULL to allocate.");
+            break;
+        case TOPIC_TABLE_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Input topic table must not be NULL.");
+            break;
+        case TOPIC_TABLE_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Could not allocate memory for the topic table.");
+            break;
+        case TOPIC_TABLE_TOPIC_NOT_FOUND:
+            fprintf(stderr, "[DEBUG] Topic is not interned in the topic table.");
+            break;
+        case TOPIC_TABLE_SUB_NOT_FOUND:
+            fprintf(stderr, "[DEBUG] Client is not a subscriber of the topic.");
+            break;
+        case UDP_BATCH_INPUT_IS_NOT_NULL:
+            fprintf(stderr, "[DEBUG] Input udp batch must be NULL to allocate.");
+            break;
+        case UDP_BATCH_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Input udp batch must not be NULL.");
+            break;
+        case UDP_BATCH_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Could not allocate the udp datagram slots.");
+            break;
+        case UDP_BATCH_FAILED_RECV:
+            fprintf(stderr, "[DEBUG] Could not receive the udp datagrams.");
+            break;
+        case TCP_WRITER_FULL:
+            fprintf(stderr, "[DEBUG] The outbound queue of the client is full.");
+            break;
+        case MSG_STORE_INPUT_IS_NOT_NULL:
+            fprintf(stderr, "[DEBUG] Input message store must be NULL to allocate.");
+            break;
+        case MSG_STORE_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Input message store must not be NULL.");
+            break;
+        case MSG_STORE_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Could not allocate a message store segment.");
+            break;
+        case MSG_STORE_SEQ_NOT_FOUND:
+            fprintf(stderr, "[DEBUG] The message is not retained by the store.");
+            break;
+        case JOURNAL_INPUT_IS_NOT_NULL:
+            fprintf(stderr, "[DEBUG] Input journal must be NULL to allocate.");
+            break;
+        case JOURNAL_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Input journal must not be NULL.");
+            break;
+        case JOURNAL_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Failed to allocate memory for the journal.");
+            break;
+        case JOURNAL_FAILED_IO:
+            fprintf(stderr, "[DEBUG] Failed to write or map the journal file.");
+            break;
+        case JOURNAL_INVALID_FILE:
+            fprintf(stderr, "[DEBUG] The journal file has an unknown format.");
+            break;
+        case SERVER_FAILED_JOURNAL:
+            fprintf(stderr, "[DEBUG] Server failed to open the journal.");
+            break;
+        case SHARD_INBOX_INPUT_IS_NOT_NULL:
+            fprintf(stderr, "[DEBUG] Shard inbox input is not NULL.");
+            break;
+        case SHARD_INBOX_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Shard inbox input is NULL.");
+            break;
+        case SHARD_INBOX_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Shard inbox failed to allocate memory.");
+            break;
+        case SHARD_INBOX_FULL:
+            fprintf(stderr, "[DEBUG] Shard inbox is full, the message was dropped.");
+            break;
+        case SERVER_POOL_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Server pool input is NULL.");
+            break;
+        case SERVER_POOL_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Server pool failed to allocate memory.");
+            break;
+        case SERVER_POOL_FAILED_THREAD:
+            fprintf(stderr, "[DEBUG] Server pool failed to start a worker thread.");
+            break;
+        case SERVER_FAILED_SHARD_INBOX:
+            fprintf(stderr, "[DEBUG] Server failed to create the queues of the worker shard.");
+            break;
+        case SPSC_RING_INPUT_IS_NOT_NULL:
+            fprintf(stderr, "[DEBUG] Ring input is not NULL.");
+            break;
+        case SPSC_RING_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Ring input is NULL.");
+            break;
+        case SPSC_RING_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Ring failed to allocate memory.");
+            break;
+        case SPSC_RING_FULL:
+            fprintf(stderr, "[DEBUG] Ring is full, the entry was dropped.");
+            break;
+        case SPSC_RING_EMPTY:
+            fprintf(stderr, "[DEBUG] Ring has no entries.");
+            break;
+        case URING_INPUT_IS_NOT_NULL:
+            fprintf(stderr, "[DEBUG] Io_uring input is not NULL.");
+            break;
+        case URING_INPUT_IS_NULL:
+            fprintf(stderr, "[DEBUG] Io_uring input is NULL.");
+            break;
+        case URING_FAILED_ALLOCATION:
+            fprintf(stderr, "[DEBUG] Io_uring failed to map its rings.");
+            break;
+        case URING_FAILED_SETUP:
+            fprintf(stderr, "[DEBUG] Io_uring is not supported by the kernel.");
+            break;
+        case URING_FAILED_SUBMIT:
+            fprintf(stderr, "[DEBUG] Io_uring failed to submit the operations.");
+            break;
+        case POLL_VEC_FAILED_URING:
+            fprintf(stderr, "[DEBUG] Poll vector could not use the io_uring backend.");
+            break;
         default:
             fprintf(stderr, "[DEBUG] Unknown command.");
     }
@@ -219,3 +360,21 @@ uint32_t ipow(uint32_t base, uint8_t exp) {
 
     return base_to_exp;
 }
+
+/**
+ * @brief Hashes a null terminated string with
+ * the 64 bits FNV-1a function.
+ *
+ * @param str string to hash.
+ * @return uint64_t hash of the string.
+ */
+uint64_t hash_str(const char *str) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (; *str != '\0'; ++str) {
+        hash ^= (uint8_t)*str;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}